@@ -2,6 +2,9 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# 开始分析在后台线程中进行
+QT += concurrent
+
 CONFIG += c++11
 
 # You can make your code fail to compile if it uses deprecated APIs.
@@ -18,6 +21,9 @@ HEADERS += \
 FORMS += \
     widget.ui
 
+# 核心算法，和命令行工具 cli/regex2lex.pro 共用
+include(lexcore.pri)
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
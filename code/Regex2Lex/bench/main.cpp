@@ -0,0 +1,302 @@
+﻿/****************************************************
+ * @FileName: main.cpp
+ * @Brief: 自动机构造的性能测试 regex2lex_bench
+ * @Module Function: 对自带的TINY、Mini-C规则和生成的压力规则依次运行
+ *                   handleAllRegex -> regex2NFA -> NFA2DFA -> DFAminimize，再写出和读回自动机缓存，
+ *                   输出每个阶段的用时、内存峰值和状态数，用于发现构造算法的性能退化
+ *
+ ****************************************************/
+#include "../lexcore.h"
+#include "../specgen.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 自带规则文件所在的目录，qmake 工程中设为源代码目录
+#ifndef REGEX2LEX_SPEC_DIR
+#define REGEX2LEX_SPEC_DIR ".."
+#endif
+
+// 命令行选项
+struct BenchOptions
+{
+    vector<string> specs;       // 规则文件或生成规则的名称，为空时运行全部自带规则
+    int repeats = 1;            // 每份规则运行的次数，用时取最小值
+    int threads = 0;            // 子集构造的线程数，0为CPU核数
+    bool perRule = false;       // 按规则构造DFA再合并
+    bool ignoreCase = false;    // 忽略大小写
+    bool csv = false;           // 输出CSV
+};
+
+// 一份要测试的规则
+struct BenchSpec
+{
+    string name;
+    string rules;
+};
+
+void printUsage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [spec ...]\n"
+            "Runs handleAllRegex -> regex2NFA -> NFA2DFA -> DFAminimize on each spec and prints\n"
+            "wall time, peak RSS and state counts per phase. The last two phases save the automaton cache\n"
+            "and load it back, as a warm start of the GUI does.\n"
+            "\n"
+            "A spec is the name of a built-in spec or a rule file (built-in names win; write ./tiny for a file):\n"
+            "  tiny, minic                  the bundled TINY and Mini-C rules\n"
+            "  keywords<n>                  n keywords in one alternation, before an identifier rule\n"
+            "  nest<n>                      n nested + closures: ((a)+b)+c ...\n"
+            "  blowup<n>                    (a|b)*a(a|b){n}, the DFA has 2^(n+1) states\n"
+            "  classes<n>                   n rules with wide overlapping ASCII and UTF-8 character classes\n"
+            "Without specs all of these run: %s\n"
+            "\n"
+            "Options:\n"
+            "  -n <count>                   run each spec count times and report the fastest (default: 1)\n"
+            "  -j <n>                       threads for the subset construction (default: number of cores)\n"
+            "  -r                           build a DFA per rule and merge them (rules2DFA) instead of NFA2DFA\n"
+            "  -i                           ignore case\n"
+            "  -c                           print CSV\n"
+            "\n"
+            "Peak RSS is the maximum of the whole process so far; run a single spec to measure it alone.\n",
+            program, "tiny minic keywords200 keywords2000 nest100 nest1000 blowup8 blowup12 blowup16 classes20 classes40");
+}
+
+// 解析命令行，出错时返回错误信息
+string parseOptions(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-r") {
+            options.perRule = true;
+        } else if (arg == "-i") {
+            options.ignoreCase = true;
+        } else if (arg == "-c") {
+            options.csv = true;
+        } else if (arg == "-n" || arg == "-j") {
+            if (i + 1 >= argc) return "missing value for " + arg;
+            string value = argv[++i];
+            int n = atoi(value.c_str());
+            if (n < 1) return "bad value for " + arg + ": " + value;
+            (arg == "-n" ? options.repeats : options.threads) = n;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            return "unknown option: " + arg;
+        } else {
+            options.specs.push_back(arg);
+        }
+    }
+    if (options.specs.empty()) {
+        options.specs = {"tiny", "minic", "keywords200", "keywords2000", "nest100", "nest1000",
+                         "blowup8", "blowup12", "blowup16", "classes20", "classes40"};
+    }
+    return "";
+}
+
+// 读入整个文件，失败时返回false
+bool readFile(const string& path, string& text)
+{
+    ifstream stream(path, ios::binary);
+    if (!stream) return false;
+    text.assign((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+    return true;
+}
+
+// 名称后面的数字，不是 prefix 加数字时返回-1
+int sizeSuffix(const string& name, const string& prefix)
+{
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) return -1;
+    string digits = name.substr(prefix.size());
+    if (digits.find_first_not_of("0123456789") != string::npos || digits.size() > 6) return -1;
+    return atoi(digits.c_str());
+}
+
+// 按名称取得规则：先当作自带或生成的规则，不是这些名称时才当作文件，返回错误信息。
+// 这样当前目录下恰好有名为 tiny 或 blowup12 的文件时，自带的测试仍然不变；要读这样的文件写成 ./tiny
+string loadSpec(const string& name, BenchSpec& spec)
+{
+    spec.name = name;
+    if (name == "tiny") {
+        return readFile(string(REGEX2LEX_SPEC_DIR) + "/tiny_regex.txt", spec.rules) ? "" : "cannot open tiny_regex.txt";
+    }
+    if (name == "minic") {
+        return readFile(string(REGEX2LEX_SPEC_DIR) + "/mini-c语言的测试/minic_regex.txt", spec.rules) ? ""
+                                                                                           : "cannot open minic_regex.txt";
+    }
+    int n;
+    if ((n = sizeSuffix(name, "keywords")) > 0) {
+        spec.rules = keywordSpec(n);
+    } else if ((n = sizeSuffix(name, "nest")) > 0) {
+        spec.rules = nestSpec(n);
+    } else if ((n = sizeSuffix(name, "blowup")) >= 0) {
+        spec.rules = blowupSpec(n);
+    } else if ((n = sizeSuffix(name, "classes")) > 0) {
+        spec.rules = classesSpec(n);
+    } else if (!readFile(name, spec.rules)) {
+        return "no such file or built-in spec: " + name;
+    }
+    return "";
+}
+
+/*============================计时和内存==================================*/
+
+// 进程开始以来的内存峰值（KB）
+long peakRssKB()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;  // macOS 以字节为单位
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// 一个阶段的结果
+struct PhaseResult
+{
+    string phase;
+    double ms = 0;      // 多次运行中最短的用时
+    long peakKB = 0;    // 阶段结束时的内存峰值
+    long count = 0;     // 阶段得到的状态数（或规则数、原子数）
+    string unit;        // count 的含义
+};
+
+// 逐个阶段计时
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(vector<PhaseResult>& phases) : phases(phases), index(0), start(chrono::steady_clock::now()) {}
+
+    // 一个阶段结束，第一次运行时加入结果，之后只更新最短用时
+    void done(const string& phase, long count, const string& unit)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        double ms = chrono::duration<double, milli>(now - start).count();
+        if (index == phases.size()) {
+            PhaseResult result;
+            result.phase = phase;
+            result.ms = ms;
+            result.count = count;
+            result.unit = unit;
+            phases.push_back(result);
+        } else {
+            phases[index].ms = min(phases[index].ms, ms);
+        }
+        phases[index].peakKB = peakRssKB();
+        index++;
+        start = chrono::steady_clock::now();
+    }
+
+private:
+    vector<PhaseResult>& phases;
+    size_t index;
+    chrono::steady_clock::time_point start;
+};
+
+/*
+* @brief 对一份规则运行一遍构造流程，和"开始分析"按钮相同，返回错误信息
+* DFA状态数超过 eagerDFAStateLimit 时只记到字节原子为止，tooManyStates 为true
+*/
+string runPipeline(const BenchSpec& spec, const BenchOptions& options, vector<PhaseResult>& phases, bool& tooManyStates)
+{
+    LexerCompilation lc;
+    lc.isLowerCase = options.ignoreCase;
+    lc.subsetThreads = options.threads;
+    PhaseTimer timer(phases);
+
+    string error = lc.handleAllRegex(spec.rules, lc.isLowerCase);
+    if (!error.empty()) return error;
+    timer.done("parse", (long)lc.acceptTags.size(), "tokens");
+
+    NFA nfa = lc.regex2NFA();
+    timer.done("nfa", lc.nfaArena.stateCount, "states");
+
+    lc.splitSymbolAtoms();
+    timer.done("atoms", (long)lc.dfaCharSet.size(), "atoms");
+
+    bool complete = options.perRule ? lc.rules2DFA(nullptr, eagerDFAStateLimit)
+                                    : lc.NFA2DFA(nfa, eagerDFAStateLimit);
+    if (!complete) {
+        tooManyStates = true;
+        return "";
+    }
+    timer.done("dfa", (long)lc.dfaTable.size(), "states");
+
+    lc.DFAminimize();
+    timer.done("minimize", (long)lc.dfaMinTable.size(), "states");
+
+    lc.DFAbyteClasses();
+    timer.done("classes", lc.byteClassCount, "classes");
+
+    // 和"开始分析"一样写出自动机缓存，再读回一份，读入用时即规则没变时再次分析的用时
+    string cacheSpec = automatonCacheSpec(spec.rules, lc.isLowerCase, lc.nfaConstruction, options.perRule);
+    string blob = lc.saveAutomaton(cacheSpec);
+    timer.done("cache-save", (long)(blob.size() / 1024), "KB");
+
+    LexerCompilation cached;
+    error = cached.loadAutomaton(blob.data(), blob.size(), cacheSpec);
+    if (!error.empty()) return error;
+    timer.done("cache-load", (long)cached.dfaMinTable.size(), "states");
+    return "";
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    string error = parseOptions(argc, argv, options);
+    if (!error.empty()) {
+        fprintf(stderr, "Error: %s\n\n", error.c_str());
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if (options.csv) {
+        printf("spec,phase,ms,peak_rss_kb,count,unit\n");
+    } else {
+        printf("%-16s %-10s %12s %14s %12s\n", "spec", "phase", "time(ms)", "peak RSS(KB)", "count");
+    }
+
+    int failures = 0;
+    for (const string& name : options.specs) {
+        BenchSpec spec;
+        error = loadSpec(name, spec);
+        if (error.empty()) {
+            vector<PhaseResult> phases;
+            bool tooManyStates = false;
+            for (int i = 0; i < options.repeats && error.empty(); i++) {
+                error = runPipeline(spec, options, phases, tooManyStates);
+            }
+            for (const PhaseResult& p : phases) {
+                if (options.csv) {
+                    printf("%s,%s,%.3f,%ld,%ld,%s\n", name.c_str(), p.phase.c_str(), p.ms, p.peakKB, p.count, p.unit.c_str());
+                } else {
+                    printf("%-16s %-10s %12.3f %14ld %12ld %s\n", name.c_str(), p.phase.c_str(), p.ms, p.peakKB, p.count,
+                           p.unit.c_str());
+                }
+            }
+            if (tooManyStates) {
+                fprintf(stderr, "%s: DFA over %d states, stopped after the atoms phase\n", name.c_str(), eagerDFAStateLimit);
+            }
+        }
+        if (!error.empty()) {
+            fprintf(stderr, "%s: %s\n", name.c_str(), error.c_str());
+            failures++;
+        }
+        fflush(stdout);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+# 自动机构造的性能测试 regex2lex_bench：对自带规则和生成的压力规则
+# 输出各阶段的用时、内存峰值和状态数，不使用Qt库
+
+TEMPLATE = app
+TARGET = regex2lex_bench
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+# 自带的 tiny_regex.txt 和 minic_regex.txt 从源代码目录读入
+DEFINES += REGEX2LEX_SPEC_DIR=\\\"$$PWD/..\\\"
+
+# Windows 上用 GetProcessMemoryInfo 取内存峰值
+win32: LIBS += -lpsapi
+
+SOURCES += \
+    main.cpp
+
+# 和回归测试共用的压力规则生成
+HEADERS += \
+    ../specgen.h
+
+include(../lexcore.pri)
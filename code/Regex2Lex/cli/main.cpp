@@ -0,0 +1,231 @@
+﻿/****************************************************
+ * @FileName: main.cpp
+ * @Brief: 命令行工具 regex2lex
+ * @Module Function: 读入规则文件，生成词法分析程序或输出NFA、DFA、最小化DFA的状态转换表，
+ *                   和图形界面使用同一套核心算法（lexcore），不需要Qt和图形界面
+ *
+ ****************************************************/
+#include "../lexcore.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// 命令行选项
+struct CliOptions
+{
+    string specFile;                            // 规则文件
+    string outputFile;                          // 输出文件，"-" 为标准输出
+    int langIndex = 0;                          // 0为TINY，1为Mini-C
+    bool ignoreCase = false;                    // 忽略大小写
+    LexerBackend backend = LEXER_TABLE;         // 生成代码的形式
+    NFAConstruction construction = NFA_THOMPSON;
+    string table;                               // 不为空时输出状态转换表：nfa、dfa 或 min
+    int threads = 0;                            // 子集构造的线程数，0为CPU核数
+    bool perRule = false;                       // 按规则构造DFA再合并
+    bool verbose = false;                       // 输出调试信息
+};
+
+void printUsage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <spec>\n"
+            "Reads the regex rules in <spec> (one name=regex per line) and writes a lexer in C.\n"
+            "\n"
+            "Options:\n"
+            "  -o <file>                    output file, - for stdout (default: lexer.c, tables go to stdout)\n"
+            "  -l tiny|minic                language of the comments and the result header (default: tiny)\n"
+            "  -i                           ignore case\n"
+            "  -b table|direct              table-driven or direct-coded lexer (default: table)\n"
+            "  -n thompson|glushkov         regex to NFA construction (default: thompson)\n"
+            "  -t nfa|dfa|min               print a transition table (tab separated) instead of the lexer\n"
+            "  -j <n>                       threads for the subset construction (default: number of cores)\n"
+            "  -r                           build a DFA per rule in parallel and merge them by product construction\n"
+            "  -v                           print debug messages to stderr\n"
+            "\n"
+            "Example: %s -l minic -o lexer.c minic_regex.txt\n",
+            program, program);
+}
+
+// 解析命令行，出错时返回错误信息
+string parseOptions(int argc, char* argv[], CliOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-i") {
+            options.ignoreCase = true;
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (arg == "-r") {
+            options.perRule = true;
+        } else if (arg == "-o" || arg == "-l" || arg == "-b" || arg == "-n" || arg == "-t" || arg == "-j") {
+            if (!hasValue) return "missing value for " + arg;
+            string value = argv[++i];
+            if (arg == "-o") {
+                options.outputFile = value;
+            } else if (arg == "-l") {
+                if (value != "tiny" && value != "minic") return "unknown language: " + value;
+                options.langIndex = (value == "tiny") ? 0 : 1;
+            } else if (arg == "-b") {
+                if (value != "table" && value != "direct") return "unknown backend: " + value;
+                options.backend = (value == "table") ? LEXER_TABLE : LEXER_DIRECT;
+            } else if (arg == "-n") {
+                if (value != "thompson" && value != "glushkov") return "unknown construction: " + value;
+                options.construction = (value == "thompson") ? NFA_THOMPSON : NFA_GLUSHKOV;
+            } else if (arg == "-j") {
+                options.threads = atoi(value.c_str());
+                if (options.threads < 1) return "bad thread count: " + value;
+            } else {
+                if (value != "nfa" && value != "dfa" && value != "min") return "unknown table: " + value;
+                options.table = value;
+            }
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            return "unknown option: " + arg;
+        } else if (options.specFile.empty()) {
+            options.specFile = arg;
+        } else {
+            return "more than one spec file";
+        }
+    }
+    if (options.specFile.empty()) return "no spec file";
+    if (options.outputFile.empty()) {
+        options.outputFile = options.table.empty() ? "lexer.c" : "-";
+    }
+    return "";
+}
+
+// 一行表格，各列用制表符分开
+void appendRow(string& out, const vector<string>& cells)
+{
+    for (size_t i = 0; i < cells.size(); i++) {
+        if (i > 0) out += '\t';
+        out += cells[i];
+    }
+    out += '\n';
+}
+
+/*
+* @brief 状态转换表的文本形式，列和图形界面中"查看NFA"、"查看DFA"、"最小化DFA"的表格相同
+* 第一行是表头：标志、ID（DFA为状态集合），之后每个输入符号一列
+*/
+string transitionTable(const LexerCompilation& lc, const string& table)
+{
+    const set<int>& symbols = (table == "nfa") ? lc.nfaCharSet : lc.dfaCharSet;
+    map<int, size_t> column;
+    vector<string> header = {"标志", table == "dfa" ? "状态集合" : "ID"};
+    for (int sym : symbols) {
+        column[sym] = header.size();
+        header.push_back(lc.symbolName(sym));
+    }
+
+    string out;
+    appendRow(out, header);
+    if (table == "nfa") {
+        for (int id : lc.insertionOrder) {
+            const statusTableNode& node = lc.statusTable[id];
+            vector<string> cells(header.size());
+            cells[0] = node.flag;
+            cells[1] = to_string(node.id);
+            for (const auto& entry : node.m) {
+                cells[column[entry.first]] = set2string(entry.second);
+            }
+            appendRow(out, cells);
+        }
+    } else if (table == "dfa") {
+        for (size_t i = 0; i < lc.dfaTable.size(); i++) {
+            vector<string> cells(header.size());
+            cells[0] = lc.dfaTable[i].flag + lc.tagLabel(lc.dfaTable[i].tag);
+            cells[1] = lc.dfaStateLabel(i + 1);
+            for (const auto& entry : lc.dfaTable[i].transitions) {
+                cells[column[entry.first]] = lc.dfaStateLabel(entry.second);
+            }
+            appendRow(out, cells);
+        }
+    } else {
+        for (const dfaMinNode& node : lc.dfaMinTable) {
+            vector<string> cells(header.size());
+            cells[0] = node.flag + lc.tagLabel(node.tag);
+            cells[1] = to_string(node.id);
+            for (const auto& entry : node.transitions) {
+                if (entry.second != -1) cells[column[entry.first]] = to_string(entry.second);
+            }
+            appendRow(out, cells);
+        }
+    }
+    return out;
+}
+
+// 和"开始分析"按钮相同的流程：规则 -> NFA -> DFA -> 最小化DFA -> 字节等价类，返回错误信息
+// 命令行每次只编译一次，按规则构造时不需要规则DFA缓存
+string buildAutomata(LexerCompilation& lc, const string& allRegex, const CliOptions& options)
+{
+    lc.isLowerCase = options.ignoreCase;
+    lc.nfaConstruction = options.construction;
+    lc.subsetThreads = options.threads;
+
+    string result = lc.handleAllRegex(allRegex, lc.isLowerCase);
+    if (!result.empty()) {
+        return result;
+    }
+    NFA nfa = lc.regex2NFA();
+    if (options.table == "nfa") {
+        return "";
+    }
+    lc.splitSymbolAtoms();
+    bool complete = options.perRule ? lc.rules2DFA(nullptr, eagerDFAStateLimit)
+                                    : lc.NFA2DFA(nfa, eagerDFAStateLimit);
+    if (!complete) {
+        return "DFA状态数超过 " + to_string(eagerDFAStateLimit) + "，没有构造完整的DFA";
+    }
+    lc.DFAminimize();
+    lc.DFAbyteClasses();
+    return "";
+}
+
+int main(int argc, char* argv[])
+{
+    CliOptions options;
+    string error = parseOptions(argc, argv, options);
+    if (!error.empty()) {
+        fprintf(stderr, "Error: %s\n\n", error.c_str());
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.verbose) {
+        coreDebugSink = [](const string& message) { cerr << message << '\n'; };
+    }
+
+    ifstream specStream(options.specFile, ios::binary);
+    if (!specStream) {
+        fprintf(stderr, "Error: Cannot open spec file: %s\n", options.specFile.c_str());
+        return 1;
+    }
+    string allRegex((istreambuf_iterator<char>(specStream)), istreambuf_iterator<char>());
+
+    LexerCompilation lc;
+    error = buildAutomata(lc, allRegex, options);
+    if (!error.empty()) {
+        fprintf(stderr, "Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    string output = options.table.empty() ? lc.generateLexer(options.langIndex, options.backend)
+                                          : transitionTable(lc, options.table);
+    if (options.outputFile == "-") {
+        fwrite(output.data(), 1, output.size(), stdout);
+        return 0;
+    }
+    ofstream outputStream(options.outputFile, ios::binary);
+    outputStream.write(output.data(), output.size());
+    outputStream.close();
+    if (!outputStream) {
+        fprintf(stderr, "Error: Cannot write output file: %s\n", options.outputFile.c_str());
+        return 1;
+    }
+    if (options.verbose) {
+        fprintf(stderr, "NFA: %d states, DFA: %d states, minimized DFA: %d states\n",
+                lc.nfaArena.stateCount, (int)lc.dfaTable.size(), (int)lc.dfaMinTable.size());
+    }
+    return 0;
+}
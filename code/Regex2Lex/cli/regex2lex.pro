@@ -0,0 +1,18 @@
+# 命令行工具 regex2lex：读入规则文件，生成词法分析程序或状态转换表
+# 不使用Qt库，也不需要图形环境
+
+TEMPLATE = app
+TARGET = regex2lex
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+SOURCES += \
+    main.cpp
+
+include(../lexcore.pri)
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,3853 @@
+﻿/****************************************************
+ * @FileName: lexcore.cpp
+ * @Brief: 词法分析器生成的核心算法，见 lexcore.h
+ *
+ ****************************************************/
+#include "lexcore.h"
+#include <iostream>
+#include <stack>
+#include <unordered_map>
+#include <queue>
+#include <unordered_set>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+
+// 如果源文件本身是UTF-8，这一行通常不是必须的，但在Windows MSVC下有助于识别字符串字面量
+#pragma execution_character_set("utf-8")
+
+void (*coreDebugSink)(const string& message) = nullptr;
+
+/*
+* @brief set转string
+* 用于结果展示
+*/
+string set2string(set<int> s)
+{
+    string result;
+
+    for (int i : s) {
+        result.append(to_string(i));
+        result.append(",");
+    }
+
+    if (result.size() != 0)
+        result.pop_back(); //弹出最后一个逗号
+
+    return result;
+}
+
+// 按分隔符拆分字符串，skipEmpty 为true时去掉空串
+vector<string> splitString(const string& str, char sep, bool skipEmpty = false)
+{
+    vector<string> parts;
+    size_t begin = 0;
+    while (true) {
+        size_t end = str.find(sep, begin);
+        string part = str.substr(begin, end == string::npos ? string::npos : end - begin);
+        if (!skipEmpty || !part.empty()) parts.push_back(part);
+        if (end == string::npos) break;
+        begin = end + 1;
+    }
+    return parts;
+}
+
+// 去掉两端的空白（空格、制表符、回车、换行等）
+string trimString(const string& str)
+{
+    const char* space = " \t\r\n\v\f";
+    size_t begin = str.find_first_not_of(space);
+    if (begin == string::npos) return "";
+    return str.substr(begin, str.find_last_not_of(space) - begin + 1);
+}
+
+// ASCII字母转小写，UTF-8的多字节字符不变
+string asciiLower(string str)
+{
+    for (char& c : str) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+    }
+    return str;
+}
+
+// ASCII字母转大写
+string asciiUpper(string str)
+{
+    for (char& c : str) {
+        if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+    }
+    return str;
+}
+
+/*
+* @brief 获取关键词列表
+*/
+void LexerCompilation::getKeyWords(const string& regex) {
+    for (const string& s : splitString(regex, '|')) {
+        keyWords.insert(s);
+    }
+}
+
+/*
+* @brief 获取操作符号的名称
+*/
+string LexerCompilation::getOpName(const string& regex1, const string& regex2) {
+    vector<string> op = splitString(regex1, '|');
+    vector<string> opName = splitString(regex2, '|');
+    if (op.size() != opName.size()) {
+        return "操作符和操作符名称个数不一致！";
+    }
+    for (size_t i = 0; i < op.size(); i++) {
+        opMap[op[i]] = opName[i];
+    }
+    return "";
+}
+
+/*
+* @brief 获取注释符号
+*/
+string LexerCompilation::getCommentSymbol(string& regex) {
+    vector<string> t = splitString(regex, '~');
+    if (t.size() != 2) return "注释输入格式错误";
+    commentSymbol[0] = t[0];
+    commentSymbol[1] = t[1];
+    regex = t[0] + "~*" + t[1];
+    return "";
+}
+
+/*============================输入符号==================================*/
+
+// 单个字节的显示形式，不可见字符和非ASCII字节写成 \xHH
+string byteName(unsigned char b)
+{
+    if (b == '\n') return "\\n";
+    if (b == '\t') return "\\t";
+    if (b == '\r') return "\\r";
+    if (b > ' ' && b < 127) return string(1, (char)b);
+    const char* hex = "0123456789ABCDEF";
+    return string("\\x") + hex[b >> 4] + hex[b & 15];
+}
+
+// 字符类中的字节，[ ] - \ 这几个字符要转义
+string classByteName(unsigned char b)
+{
+    if (b == '[' || b == ']' || b == '-' || b == '\\') return string("\\") + (char)b;
+    return byteName(b);
+}
+
+// 字节集合的显示形式，如 [a-ce-z]，两个字节的区间写成 [ab]
+string rangesDisplay(const ByteRanges& ranges)
+{
+    string result = "[";
+    for (const auto& r : ranges) {
+        result += classByteName(r.first);
+        if (r.second > r.first + 1) {
+            result += '-';
+        }
+        if (r.second > r.first) {
+            result += classByteName(r.second);
+        }
+    }
+    return result + "]";
+}
+
+// 区间排序，重叠或相邻的区间合并
+void normalizeRanges(ByteRanges& ranges)
+{
+    sort(ranges.begin(), ranges.end());
+    ByteRanges merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && r.first <= merged.back().second + 1) {
+            merged.back().second = max(merged.back().second, r.second);
+        } else {
+            merged.push_back(r);
+        }
+    }
+    ranges.swap(merged);
+}
+
+// 区间集合包含的字节数
+int rangesSize(const ByteRanges& ranges)
+{
+    int n = 0;
+    for (const auto& r : ranges) {
+        n += r.second - r.first + 1;
+    }
+    return n;
+}
+
+// 查找符号，不存在则加入符号表，返回符号编号
+int LexerCompilation::internSymbol(const string& name, const ByteRanges& ranges)
+{
+    auto key = make_pair(name, ranges);
+    auto it = symbolIndex.find(key);
+    if (it != symbolIndex.end()) {
+        return it->second;
+    }
+    symbolTable.push_back({name, ranges});
+    symbolIndex[key] = symbolTable.size() - 1;
+    return symbolTable.size() - 1;
+}
+
+// 单个字节的符号
+int LexerCompilation::byteSymbol(unsigned char b)
+{
+    return internSymbol(byteName(b), ByteRanges(1, {b, b}));
+}
+
+// 字节区间集合的符号，只有一个字节时就是该字节的符号
+int LexerCompilation::rangesSymbol(const ByteRanges& ranges)
+{
+    if (ranges.size() == 1 && ranges[0].first == ranges[0].second) {
+        return byteSymbol(ranges[0].first);
+    }
+    return internSymbol(rangesDisplay(ranges), ranges);
+}
+
+// 符号的显示形式，空边显示为 #
+string LexerCompilation::symbolName(int sym) const
+{
+    return sym == EPSILON ? "#" : symbolTable[sym].name;
+}
+
+/*
+* @brief 从 pos 处解码一个UTF-8字符，pos 移到下一个字符
+* 不是合法的UTF-8编码（含过长编码、代理区）时返回-1，pos 不变
+*/
+int decodeUtf8(const string& str, size_t& pos)
+{
+    static const int minCode[5] = {0, 0, 0x80, 0x800, 0x10000};
+    unsigned char b = str[pos];
+    int len = (b < 0x80) ? 1 : ((b >> 5) == 0x6) ? 2 : ((b >> 4) == 0xE) ? 3 : ((b >> 3) == 0x1E) ? 4 : 0;
+    if (len == 0 || pos + len > str.size()) return -1;
+
+    int cp = (len == 1) ? b : (b & (0x7F >> len));
+    for (int i = 1; i < len; i++) {
+        unsigned char c = str[pos + i];
+        if ((c & 0xC0) != 0x80) return -1;
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    if (cp < minCode[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return -1;
+    pos += len;
+    return cp;
+}
+
+// 码点的UTF-8编码
+string encodeUtf8(int cp)
+{
+    string result;
+    if (cp < 0x80) {
+        result += (char)cp;
+    } else if (cp < 0x800) {
+        result += (char)(0xC0 | (cp >> 6));
+        result += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        result += (char)(0xE0 | (cp >> 12));
+        result += (char)(0x80 | ((cp >> 6) & 0x3F));
+        result += (char)(0x80 | (cp & 0x3F));
+    } else {
+        result += (char)(0xF0 | (cp >> 18));
+        result += (char)(0x80 | ((cp >> 12) & 0x3F));
+        result += (char)(0x80 | ((cp >> 6) & 0x3F));
+        result += (char)(0x80 | (cp & 0x3F));
+    }
+    return result;
+}
+
+// UTF-8字节序列：依次各读一个字节，每个字节取值于一个区间
+typedef vector<pair<unsigned char, unsigned char>> Utf8Sequence;
+
+/*
+* @brief 把码点区间 [lo, hi] 转成UTF-8字节序列
+* 得到的各个序列互不相交，合起来恰好是区间内所有码点的编码。
+* 先按编码长度拆开，再拆到每一位字节都能独立取一个区间为止（和RE2的做法相同），
+* 如 [一-龥] (U+4E00~U+9FA5) 得到 E4 [B8-BF] [80-BF]、[E5-E8] [80-BF] [80-BF]、E9 [80-BD] [80-BF]、E9 BE [80-A5]
+*/
+void utf8Sequences(int lo, int hi, vector<Utf8Sequence>& out)
+{
+    if (lo > hi) return;
+
+    // 代理区不是合法的码点
+    if (lo <= 0xDFFF && hi >= 0xD800) {
+        utf8Sequences(lo, 0xD7FF, out);
+        utf8Sequences(0xE000, hi, out);
+        return;
+    }
+
+    // 编码长度不同的部分分开
+    static const int lenMax[3] = {0x7F, 0x7FF, 0xFFFF};
+    for (int m : lenMax) {
+        if (lo <= m && hi > m) {
+            utf8Sequences(lo, m, out);
+            utf8Sequences(m + 1, hi, out);
+            return;
+        }
+    }
+
+    // 高位不同时，低 6i 位必须覆盖全部取值，否则把不完整的头尾拆出去
+    for (int i = 1; i < 4; i++) {
+        int m = (1 << (6 * i)) - 1;
+        if ((lo & ~m) == (hi & ~m)) continue;
+        if ((lo & m) != 0) {
+            utf8Sequences(lo, lo | m, out);
+            utf8Sequences((lo | m) + 1, hi, out);
+            return;
+        }
+        if ((hi & m) != m) {
+            utf8Sequences(lo, (hi & ~m) - 1, out);
+            utf8Sequences(hi & ~m, hi, out);
+            return;
+        }
+    }
+
+    string a = encodeUtf8(lo);
+    string b = encodeUtf8(hi);
+    Utf8Sequence seq;
+    for (size_t k = 0; k < a.size(); k++) {
+        seq.push_back({(unsigned char)a[k], (unsigned char)b[k]});
+    }
+    out.push_back(seq);
+}
+
+/*============================正则表达式语法树==================================*/
+
+int LexerCompilation::newRegexNode(RegexKind kind, int sym, int left, int right)
+{
+    RegexNode node;
+    node.kind = kind;
+    node.sym = sym;
+    node.left = left;
+    node.right = right;
+    regexAst.push_back(node);
+    return regexAst.size() - 1;
+}
+
+// 单个字节的叶结点
+int LexerCompilation::byteNode(unsigned char b)
+{
+    return newRegexNode(REGEX_CHAR, byteSymbol(b));
+}
+
+// 一个字符：UTF-8编码逐字节连接，多字节字符（如汉字）整体参与闭包等运算
+int LexerCompilation::codePointNode(int cp)
+{
+    string bytes = encodeUtf8(cp);
+    int node = byteNode(bytes[0]);
+    for (size_t i = 1; i < bytes.size(); i++) {
+        node = newRegexNode(REGEX_CONCAT, -1, node, byteNode(bytes[i]));
+    }
+    return node;
+}
+
+// 变量名只由ASCII字母、数字和下划线组成
+bool isWordChar(char c)
+{
+    return ((unsigned char)c < 0x80 && isalnum((unsigned char)c)) || c == '_';
+}
+
+/*
+* @brief 正则表达式递归下降分析器
+* 一遍扫描直接建立语法树，不再插入连接符或把 X+ 展开成 XX*
+* 文法：
+*   alt    -> concat ('|' concat)*
+*   concat -> repeat repeat*
+*   repeat -> atom ('*' | '+' | '?')*
+*   atom   -> '(' alt ')' | '[' 字符 ']' | '\' 字符 | 变量名 | 字符
+* 正则表达式按UTF-8解码，多字节字符展开成它的字节序列
+*/
+struct RegexParser
+{
+    LexerCompilation& lc;   // 结点和符号加到这次编译的语法树和符号表中
+    const string& regex;
+    size_t pos;
+    string error;
+
+    RegexParser(LexerCompilation& compilation, const string& r) : lc(compilation), regex(r), pos(0) {}
+
+    // 跳过空格后的当前字符，结束时返回0
+    char peek()
+    {
+        while (pos < regex.size() && regex[pos] == ' ') pos++;
+        return pos < regex.size() ? regex[pos] : 0;
+    }
+
+    int fail(const string& msg)
+    {
+        if (error.empty()) {
+            error = msg + "，位置 " + to_string(pos) + ": " + regex;
+        }
+        return -1;
+    }
+
+    // 解析整个正则表达式，出错返回-1
+    int parse()
+    {
+        int root = parseAlt();
+        if (root != -1 && peek() != 0) {
+            return fail("正则表达式语法错误：多余的 " + string(1, peek()));
+        }
+        return root;
+    }
+
+    int parseAlt()
+    {
+        int left = parseConcat();
+        while (left != -1 && peek() == '|') {
+            pos++;
+            int right = parseConcat();
+            if (right == -1) return -1;
+            left = lc.newRegexNode(REGEX_ALT, -1, left, right);
+        }
+        return left;
+    }
+
+    int parseConcat()
+    {
+        int left = -1;
+        char c;
+        while ((c = peek()) != 0 && c != '|' && c != ')') {
+            int right = parseRepeat();
+            if (right == -1) return -1;
+            left = (left == -1) ? right : lc.newRegexNode(REGEX_CONCAT, -1, left, right);
+        }
+        if (left == -1) {
+            return fail("正则表达式语法错误：缺少运算对象");
+        }
+        return left;
+    }
+
+    int parseRepeat()
+    {
+        int node = parseAtom();
+        char c;
+        while (node != -1 && ((c = peek()) == '*' || c == '+' || c == '?')) {
+            pos++;
+            RegexKind kind = (c == '*') ? REGEX_STAR : (c == '+') ? REGEX_PLUS : REGEX_OPTIONAL;
+            node = lc.newRegexNode(kind, -1, node);
+        }
+        return node;
+    }
+
+    int parseAtom()
+    {
+        char c = peek();
+        if (c == '(') {
+            pos++;
+            int node = parseAlt();
+            if (node == -1) return -1;
+            if (peek() != ')') return fail("括号未闭合，请检查正则表达式！");
+            pos++;
+            return node;
+        }
+        if (c == '[') {
+            return parseClass();
+        }
+        if (c == '*' || c == '+' || c == '?') {
+            return fail("正则表达式语法错误：闭包操作没有运算对象");
+        }
+        if (c == ']') {
+            return fail("正则表达式语法错误：多余的 ]");
+        }
+        if (c == '\\' && pos + 1 >= regex.size()) {
+            return fail("正则表达式语法错误：\\ 后缺少字符");
+        }
+        if (isWordChar(c)) {
+            // 读入整个单词，是变量名就是变量引用，否则逐字符连接
+            size_t end = pos;
+            while (end < regex.size() && isWordChar(regex[end])) end++;
+            string word = regex.substr(pos, end - pos);
+            auto it = lc.varNodeMap.find(word);
+            if (it != lc.varNodeMap.end()) {
+                pos = end;
+                return it->second;
+            }
+            int node = -1;
+            for (; pos < end; pos++) {
+                int ch = lc.byteNode(regex[pos]);
+                node = (node == -1) ? ch : lc.newRegexNode(REGEX_CONCAT, -1, node, ch);
+            }
+            return node;
+        }
+        bool isByte;
+        int ch = readChar(isByte);
+        if (ch < 0) return -1;
+        return isByte ? lc.byteNode(ch) : lc.codePointNode(ch);
+    }
+
+    /*
+    * @brief 读入一个字符（可以是转义字符），返回码点，出错返回-1
+    * \n \t \r 为换行、制表、回车，\xHH 为任意一个字节（isByte 为true，可以不是合法的UTF-8），
+    * 其他 \ 后的字符都表示字符本身，如 \+ \| \(
+    */
+    int readChar(bool& isByte)
+    {
+        isByte = false;
+        if (regex[pos] == '\\' && pos + 1 < regex.size()) {
+            char e = regex[pos + 1];
+            pos += 2;
+            if (e == 'n') return '\n';
+            if (e == 't') return '\t';
+            if (e == 'r') return '\r';
+            if (e == 'x' && pos + 1 < regex.size() &&
+                isxdigit((unsigned char)regex[pos]) && isxdigit((unsigned char)regex[pos + 1])) {
+                isByte = true;
+                pos += 2;
+                return stoi(regex.substr(pos - 2, 2), nullptr, 16);
+            }
+            pos--;
+        }
+        int cp = decodeUtf8(regex, pos);
+        if (cp < 0) return fail("正则表达式不是合法的UTF-8编码");
+        return cp;
+    }
+
+    // 字节区间集合的叶结点，只有一个字节时是字符结点
+    int rangesNode(const ByteRanges& ranges)
+    {
+        int sym = lc.rangesSymbol(ranges);
+        return lc.newRegexNode(rangesSize(ranges) == 1 ? REGEX_CHAR : REGEX_CLASS, sym);
+    }
+
+    /*
+    * @brief 字符类，如 [A-Za-z_]、[一-龥]
+    * ASCII字符和 \xHH 字节合成一个字符类符号，范围直接记为字节区间，不展开成单个字符；
+    * 非ASCII字符的区间转成UTF-8字节序列，每个序列是字节区间的连接，各序列再和字符类做选择
+    */
+    int parseClass()
+    {
+        pos++; // 跳过[
+        ByteRanges bytes;
+        vector<pair<int, int>> ranges;
+        while (pos < regex.size() && regex[pos] != ']') {
+            if (regex[pos] == ' ') {
+                pos++;
+                continue;
+            }
+            bool loByte, hiByte;
+            int lo = readChar(loByte);
+            if (lo < 0) return -1;
+            int hi = lo;
+            if (pos + 1 < regex.size() && regex[pos] == '-' && regex[pos + 1] != ']') {
+                pos++;
+                hi = readChar(hiByte);
+                if (hi < 0) return -1;
+                if (hi < lo || hiByte != loByte) return fail("字符类范围错误");
+            }
+            if (loByte || hi < 0x80) {
+                bytes.push_back({lo, hi});
+            } else {
+                if (lo < 0x80) {
+                    bytes.push_back({lo, 0x7F});
+                    lo = 0x80;
+                }
+                ranges.push_back({lo, hi});
+            }
+        }
+        if (pos >= regex.size()) return fail("字符类缺少 ]");
+        pos++; // 跳过]
+        if (bytes.empty() && ranges.empty()) return fail("字符类为空");
+
+        int node = -1;
+        if (!bytes.empty()) {
+            normalizeRanges(bytes);
+            node = rangesNode(bytes);
+        }
+
+        // 合并重叠的码点区间后转成字节序列
+        sort(ranges.begin(), ranges.end());
+        vector<pair<int, int>> merged;
+        for (const auto& r : ranges) {
+            if (!merged.empty() && r.first <= merged.back().second + 1) {
+                merged.back().second = max(merged.back().second, r.second);
+            } else {
+                merged.push_back(r);
+            }
+        }
+        vector<Utf8Sequence> seqs;
+        for (const auto& r : merged) {
+            utf8Sequences(r.first, r.second, seqs);
+        }
+        for (const Utf8Sequence& seq : seqs) {
+            int seqNode = -1;
+            for (const auto& br : seq) {
+                int leaf = rangesNode(ByteRanges(1, br));
+                seqNode = (seqNode == -1) ? leaf : lc.newRegexNode(REGEX_CONCAT, -1, seqNode, leaf);
+            }
+            node = (node == -1) ? seqNode : lc.newRegexNode(REGEX_ALT, -1, node, seqNode);
+        }
+        return node;
+    }
+};
+
+// 把顶层的选择运算拆成各个分支，如 a|b|c 得到 a、b、c
+void LexerCompilation::collectAltBranches(int idx, vector<int>& branches) const
+{
+    if (regexAst[idx].kind == REGEX_ALT) {
+        collectAltBranches(regexAst[idx].left, branches);
+        collectAltBranches(regexAst[idx].right, branches);
+    } else {
+        branches.push_back(idx);
+    }
+}
+
+// 语法树只由字符连接而成时得到对应的字符串（UTF-8字节），否则返回false
+bool LexerCompilation::astLiteralText(int idx, string& text) const
+{
+    const RegexNode& node = regexAst[idx];
+    if (node.kind == REGEX_CONCAT) {
+        return astLiteralText(node.left, text) && astLiteralText(node.right, text);
+    }
+    if (node.kind != REGEX_CHAR) {
+        return false;
+    }
+    text += (char)symbolTable[node.sym].ranges[0].first;
+    return true;
+}
+
+/*
+* @brief 解析变量定义
+* 定义是一个字符集合（如 [A-Za-z]、单个字符）时变量本身作为输入符号，NFA和DFA表中显示变量名；
+* 其他定义（如含汉字的字符类，展开后是UTF-8字节序列的选择）引用时直接使用定义的语法树
+*/
+string LexerCompilation::defineVariable(const string& name, const string& regex)
+{
+    RegexParser parser(*this, regex);
+    int root = parser.parse();
+    if (root == -1) {
+        return "变量 " + name + "：" + parser.error;
+    }
+    RegexKind kind = regexAst[root].kind;
+    if (kind == REGEX_CHAR || kind == REGEX_CLASS || kind == REGEX_VAR) {
+        ByteRanges ranges = symbolTable[regexAst[root].sym].ranges;
+        varNodeMap[name] = newRegexNode(REGEX_VAR, internSymbol(name, ranges));
+    } else {
+        varNodeMap[name] = root;
+    }
+    return "";
+}
+
+/*
+* @brief 对正则表达式进行处理
+* 新格式：
+* 变量定义: name=regex (如 letter=[A-Za-z], digit=[0-9])
+* 生成DFA: _name数字=regex (如 _ID101=letter(letter|digit)*)
+* 说明：
+* (1) 通过命名中加下划线(_)来表示该正则表达式需要生成DFA图
+* (2) 命名中的名字后的数值为对应单词的编码
+* (3) 命名中数值后加S表示后面有多个单词（各个选择分支），编码从该数值开始，
+*     前面的规则优先，如关键字规则要写在标识符规则之前
+* (4) \ 后的字符表示字符本身，如 \+ \| \( \)；\n \t \r 为换行、制表、回车，\xHH 为任意一个字节
+* (5) 规则中可以有汉字等UTF-8字符，按字节构造自动机，变量按定义的先后顺序解析
+*/
+string LexerCompilation::handleAllRegex(const string& allRegex, bool isLowerCase) {
+    // 清空变量表
+    varDefMap.clear();
+    regexToGenerate.clear();
+    varNodeMap.clear();
+
+    // 将文本内容按行分割
+    vector<string> lines = splitString(allRegex, '\n', true);
+
+    if (lines.empty()) {
+        return "输入为空，请输入正则表达式！";
+    }
+
+    // 第一遍：解析变量定义和需要生成的正则表达式
+    for (const string& line : lines) {
+        string trimmedLine = trimString(line);
+        // 空行和以#开头的注释行跳过
+        if (trimmedLine.empty() || trimmedLine[0] == '#') continue;
+
+        // 查找等号位置（第一个等号）
+        size_t eqPos = trimmedLine.find('=');
+        if (eqPos == string::npos) {
+            return "格式错误：每行必须是 name=regex 格式，错误行: " + trimmedLine;
+        }
+
+        string nameStr = trimString(trimmedLine.substr(0, eqPos));
+        string regexStr = trimString(trimmedLine.substr(eqPos + 1));
+
+        // 不区分大小写的话，正则表达式转为小写（名称保持原样）
+        if (isLowerCase) {
+            regexStr = asciiLower(regexStr);
+        }
+
+        if (nameStr.empty() || regexStr.empty()) {
+            return "格式错误：名称或正则表达式为空，错误行: " + trimmedLine;
+        }
+
+        // 判断是否以_开头（需要生成DFA）
+        if (nameStr[0] == '_') {
+            // 提取名称和编码，格式: _NAME123 或 _NAME123S
+            string pureName = nameStr.substr(1); // 去掉下划线
+            string tokenName;
+            int tokenCode = 0;
+            bool hasS = false;
+
+            // 查找数字开始位置
+            size_t numStart = string::npos;
+            for (size_t i = 0; i < pureName.size(); i++) {
+                if (isdigit(pureName[i])) {
+                    numStart = i;
+                    break;
+                }
+            }
+
+            if (numStart != string::npos) {
+                tokenName = pureName.substr(0, numStart);
+                string numPart = pureName.substr(numStart);
+                // 检查是否以S结尾（多单词标记）
+                if (!numPart.empty() && (numPart.back() == 'S' || numPart.back() == 's')) {
+                    hasS = true;
+                    numPart.pop_back();
+                }
+                if (!numPart.empty()) {
+                    tokenCode = stoi(numPart);
+                }
+            } else {
+                tokenName = pureName;
+            }
+
+            // 多单词定义（以S结尾），各个单词在解析出语法树后按选择分支拆分
+            regexToGenerate.push_back({tokenName, regexStr, tokenCode, hasS, 0, 0});
+            CoreDebug() << "需要生成DFA: " << tokenName
+                     << " 编码: " << tokenCode
+                     << " 多单词: " << hasS
+                     << " 正则: " << regexStr;
+        } else {
+            // 普通变量定义，忽略大小写时变量名也转为小写，和规则中的引用一致
+            if (isLowerCase) {
+                nameStr = asciiLower(nameStr);
+            }
+            varDefMap[nameStr] = regexStr;
+            string error = defineVariable(nameStr, regexStr);
+            if (!error.empty()) {
+                return error;
+            }
+            CoreDebug() << "变量定义: " << nameStr
+                     << " = " << regexStr;
+        }
+    }
+
+    if (regexToGenerate.empty()) {
+        return "没有找到需要生成DFA的正则表达式（以_开头的定义）！";
+    }
+
+    // 第二遍：把每条规则解析成语法树，变量名解析为变量引用（不展开定义），
+    // 并为每个单词建立标记，多单词规则的每个选择分支是一个单词
+    acceptTags.clear();
+    tagAstRoot.clear();
+    for (TokenRule& rule : regexToGenerate) {
+        RegexParser parser(*this, rule.regex);
+        int root = parser.parse();
+        if (root == -1) {
+            return "规则 " + rule.name + "：" + parser.error;
+        }
+        CoreDebug() << "语法树: " << rule.name
+                 << " 根结点 " << root << " 结点总数 " << regexAst.size();
+
+        rule.firstTag = acceptTags.size();
+        if (!rule.multi) {
+            acceptTags.push_back({rule.name, rule.code, ""});
+            tagAstRoot.push_back(root);
+            rule.tagCount = 1;
+            continue;
+        }
+
+        vector<int> branches;
+        collectAltBranches(root, branches);
+        for (size_t k = 0; k < branches.size(); k++) {
+            string text;
+            if (!astLiteralText(branches[k], text)) text = "";
+            acceptTags.push_back({rule.name, rule.code + (int)k, text});
+            tagAstRoot.push_back(branches[k]);
+            CoreDebug() << "  单词" << k << ": " << text
+                     << " 编码: " << acceptTags.back().code;
+        }
+        rule.tagCount = branches.size();
+    }
+
+    return "";
+}
+
+/*============================正则表达式转NFA==================================*/
+
+/*
+* @brief 创建基本符号NFA
+* 只包含一个输入符号（字符、字符类或变量）的NFA图
+*/
+NFA LexerCompilation::CreateBasicNFA(int sym) {
+    int start = nfaArena.newState();
+    int end = nfaArena.newState();
+
+    nfaArena.addEdge(start, sym, end);
+
+    // 存入nfa符号set
+    nfaCharSet.insert(sym);
+
+    return NFA(start, end);
+}
+
+/*
+* @brief 创建连接运算符的NFA图
+*/
+NFA LexerCompilation::CreateConcatenationNFA(NFA nfa1, NFA nfa2) {
+    // 把nfa1的终止状态与nfa2的起始状态连接起来
+    nfaArena.addEdge(nfa1.end, EPSILON, nfa2.start); // 这里用EPSILON表示空边
+
+    return NFA(nfa1.start, nfa2.end);
+}
+
+/*
+* @brief 创建选择运算符的NFA图
+*/
+NFA LexerCompilation::CreateUnionNFA(NFA nfa1, NFA nfa2) {
+    int start = nfaArena.newState();
+    int end = nfaArena.newState();
+
+    // 把新的初态与nfa1和nfa2的初态连接起来
+    nfaArena.addEdge(start, EPSILON, nfa1.start);
+    nfaArena.addEdge(start, EPSILON, nfa2.start);
+
+    // 把nfa1和nfa2的终止状态与新的终止状态连接起来
+    nfaArena.addEdge(nfa1.end, EPSILON, end);
+    nfaArena.addEdge(nfa2.end, EPSILON, end);
+
+    return NFA(start, end);
+}
+
+/*
+* @brief 创建*运算符的NFA图
+*/
+NFA LexerCompilation::CreateZeroOrMoreNFA(NFA nfa1) {
+    int start = nfaArena.newState();
+    int end = nfaArena.newState();
+
+    // 把新的初态与nfa1的初态、新的终止状态连接起来
+    nfaArena.addEdge(start, EPSILON, nfa1.start);
+    nfaArena.addEdge(start, EPSILON, end);
+
+    // 把nfa1的终止状态连回nfa1的初态，并与新的终止状态连接起来
+    nfaArena.addEdge(nfa1.end, EPSILON, nfa1.start);
+    nfaArena.addEdge(nfa1.end, EPSILON, end);
+
+    return NFA(start, end);
+}
+
+/*
+* @brief 创建？运算符的NFA图
+*/
+NFA LexerCompilation::CreateOptionalNFA(NFA nfa1) {
+    int start = nfaArena.newState();
+    int end = nfaArena.newState();
+
+    // 把新的初态与nfa1的初态、新的终止状态连接起来
+    nfaArena.addEdge(start, EPSILON, nfa1.start);
+    nfaArena.addEdge(start, EPSILON, end);
+
+    // 把nfa1的终止状态与新的终止状态连接起来
+    nfaArena.addEdge(nfa1.end, EPSILON, end);
+
+    return NFA(start, end);
+}
+
+/*
+* @brief 创建+运算符的NFA图
+* 和*相比少了初态直接到终态的空边，子表达式不需要复制一份
+*/
+NFA LexerCompilation::CreateOneOrMoreNFA(NFA nfa1) {
+    int start = nfaArena.newState();
+    int end = nfaArena.newState();
+
+    // 把新的初态与nfa1的初态连接起来
+    nfaArena.addEdge(start, EPSILON, nfa1.start);
+
+    // 把nfa1的终止状态连回nfa1的初态，并与新的终止状态连接起来
+    nfaArena.addEdge(nfa1.end, EPSILON, nfa1.start);
+    nfaArena.addEdge(nfa1.end, EPSILON, end);
+
+    return NFA(start, end);
+}
+
+/*
+* @brief 生成状态转换表
+* 按状态编号顺序扫描CSR边表，终态取 endNFAstatus 中的状态
+*/
+void LexerCompilation::createNFAStatusTable(NFA& nfa)
+{
+    int stateCount = nfaArena.stateCount;
+    statusTable.assign(stateCount, statusTableNode());
+
+    for (int s = 0; s < stateCount; s++) {
+        statusTableNode& node = statusTable[s];
+        node.id = s;
+        // 记录状态转换信息
+        for (int e = nfaArena.edgeStart[s]; e < nfaArena.edgeStart[s + 1]; e++) {
+            node.m[nfaArena.edgeSym[e]].insert(nfaArena.edgeNext[e]);
+        }
+    }
+
+    // 初态
+    statusTable[nfa.start].flag = "-"; // -表示初态
+    startNFAstatus.insert(nfa.start);
+    // 终态
+    for (int e : endNFAstatus) {
+        statusTable[e].flag += "+"; // +表示终态
+    }
+
+    // 输出顺序：初态、其余状态、终态
+    insertionOrder.push_back(nfa.start);
+    for (int s = 0; s < stateCount; s++) {
+        if (s != nfa.start && endNFAstatus.count(s) == 0) {
+            insertionOrder.push_back(s);
+        }
+    }
+    for (int e : endNFAstatus) {
+        if (e != nfa.start) {
+            insertionOrder.push_back(e);
+        }
+    }
+}
+
+// 测试输出NFA状态转换表程序（debug使用）
+void LexerCompilation::printStatusTable() const {
+    // 打印状态表按照插入顺序
+    for (int id : insertionOrder) {
+        const statusTableNode& node = statusTable[id];
+        CoreDebug() << "Node ID: " << node.id << ", Flag: " << node.flag << "\n";
+
+        for (const auto& entry : node.m) {
+            const std::set<int>& targetStates = entry.second;
+
+            CoreDebug() << "  Transition: " << symbolName(entry.first) << " -> {";
+            for (int targetState : targetStates) {
+                CoreDebug() << targetState << " ";
+            }
+            CoreDebug() << "}\n";
+        }
+    }
+}
+
+/*
+* @brief 由语法树结点构建NFA（Thompson构造法）
+*/
+NFA LexerCompilation::ast2NFA(int idx)
+{
+    const RegexNode& node = regexAst[idx];
+    switch (node.kind)
+    {
+    case REGEX_CHAR:
+    case REGEX_CLASS:
+    case REGEX_VAR:
+        return CreateBasicNFA(node.sym);
+    case REGEX_CONCAT:
+    {
+        NFA nfa1 = ast2NFA(node.left);
+        NFA nfa2 = ast2NFA(node.right);
+        return CreateConcatenationNFA(nfa1, nfa2);
+    }
+    case REGEX_ALT:
+    {
+        NFA nfa1 = ast2NFA(node.left);
+        NFA nfa2 = ast2NFA(node.right);
+        return CreateUnionNFA(nfa1, nfa2);
+    }
+    case REGEX_STAR:
+        return CreateZeroOrMoreNFA(ast2NFA(node.left));
+    case REGEX_PLUS:
+        return CreateOneOrMoreNFA(ast2NFA(node.left));
+    case REGEX_OPTIONAL:
+        return CreateOptionalNFA(ast2NFA(node.left));
+    }
+    return NFA();
+}
+
+/*
+* @brief Glushkov构造中语法树结点的信息
+* nullable：能否匹配空串；first/last：可能出现在开头/结尾的位置（NFA状态编号）
+*/
+struct GlushkovInfo
+{
+    bool nullable;
+    vector<int> first;
+    vector<int> last;
+};
+
+/*
+* @brief 自底向上计算 nullable / first / last / follow
+* 每个字符、变量、字符类的出现是一个位置，对应一个NFA状态
+*/
+GlushkovInfo LexerCompilation::glushkovBuild(int idx)
+{
+    const RegexNode& node = regexAst[idx];
+    GlushkovInfo info;
+    switch (node.kind)
+    {
+    case REGEX_CHAR:
+    case REGEX_VAR:
+    case REGEX_CLASS:
+    {
+        int pos = nfaArena.newState();
+        glushkovPosNode.push_back(idx);
+        glushkovFollow.push_back(vector<int>());
+        info.nullable = false;
+        info.first.push_back(pos);
+        info.last.push_back(pos);
+        break;
+    }
+    case REGEX_CONCAT:
+    {
+        GlushkovInfo l = glushkovBuild(node.left);
+        GlushkovInfo r = glushkovBuild(node.right);
+        // 左边的结尾后面可以跟右边的开头
+        for (int p : l.last) {
+            glushkovFollow[p - 1].insert(glushkovFollow[p - 1].end(), r.first.begin(), r.first.end());
+        }
+        info.nullable = l.nullable && r.nullable;
+        info.first = l.first;
+        if (l.nullable) info.first.insert(info.first.end(), r.first.begin(), r.first.end());
+        info.last = r.last;
+        if (r.nullable) info.last.insert(info.last.end(), l.last.begin(), l.last.end());
+        break;
+    }
+    case REGEX_ALT:
+    {
+        GlushkovInfo l = glushkovBuild(node.left);
+        GlushkovInfo r = glushkovBuild(node.right);
+        info.nullable = l.nullable || r.nullable;
+        info.first = l.first;
+        info.first.insert(info.first.end(), r.first.begin(), r.first.end());
+        info.last = l.last;
+        info.last.insert(info.last.end(), r.last.begin(), r.last.end());
+        break;
+    }
+    case REGEX_STAR:
+    case REGEX_PLUS:
+    case REGEX_OPTIONAL:
+    {
+        info = glushkovBuild(node.left);
+        if (node.kind != REGEX_OPTIONAL) {
+            // 重复：结尾后面可以回到开头
+            for (int p : info.last) {
+                glushkovFollow[p - 1].insert(glushkovFollow[p - 1].end(), info.first.begin(), info.first.end());
+            }
+        }
+        if (node.kind != REGEX_PLUS) info.nullable = true;
+        break;
+    }
+    }
+    return info;
+}
+
+// 进入位置 pos 的边，边上是该位置的符号
+void LexerCompilation::glushkovAddEdges(int from, int pos)
+{
+    int sym = regexAst[glushkovPosNode[pos - 1]].sym;
+    nfaArena.addEdge(from, sym, pos);
+    nfaCharSet.insert(sym);
+}
+
+/*
+* @brief Glushkov构造（位置自动机）
+* 0号状态为初态，其余每个状态对应一个位置，没有ε边：
+* 初态到各规则的first位置、位置p到follow(p)中的位置各有一条边，边上是目标位置的符号。
+* 规则的last位置（规则能匹配空串时还有初态）是该规则的终态
+*/
+NFA LexerCompilation::glushkovNFA()
+{
+    glushkovPosNode.clear();
+    glushkovFollow.clear();
+    int start = nfaArena.newState();
+
+    for (size_t i = 0; i < tagAstRoot.size(); i++)
+    {
+        GlushkovInfo info = glushkovBuild(tagAstRoot[i]);
+        for (int q : info.first) {
+            glushkovAddEdges(start, q);
+        }
+        vector<int> finals = info.last;
+        if (info.nullable) finals.push_back(start);
+        tagEndNFAstatus.push_back(finals);
+        endNFAstatus.insert(finals.begin(), finals.end());
+    }
+
+    // 嵌套的闭包会重复加入同一个follow位置，去重后连边
+    for (int p = 1; p < nfaArena.stateCount; p++) {
+        vector<int>& follow = glushkovFollow[p - 1];
+        sort(follow.begin(), follow.end());
+        follow.erase(unique(follow.begin(), follow.end()), follow.end());
+        for (int q : follow) {
+            glushkovAddEdges(p, q);
+        }
+    }
+
+    // 终态不唯一，只返回初态
+    return NFA(start, -1);
+}
+
+// Thompson构造：每个单词标记的语法树分别构建NFA，记录各自的终态后再用选择运算合并
+NFA LexerCompilation::thompsonNFA()
+{
+    NFA result;
+    for (size_t i = 0; i < tagAstRoot.size(); i++)
+    {
+        NFA tagNFA = ast2NFA(tagAstRoot[i]);
+        tagEndNFAstatus.push_back({tagNFA.end});
+        result = (i == 0) ? tagNFA : CreateUnionNFA(result, tagNFA);
+    }
+    endNFAstatus.insert(result.end);
+    return result;
+}
+
+/*
+* @brief 正则表达式转NFA入口
+* 按 nfaConstruction 选择构造方法，两种方法得到的DFA接受相同的单词
+*/
+NFA LexerCompilation::regex2NFA()
+{
+    NFA result = (nfaConstruction == NFA_GLUSHKOV) ? glushkovNFA() : thompsonNFA();
+    nfaArena.finalize();
+    CoreDebug() << "NFA图构建完毕，状态数 " << nfaArena.stateCount << " 边数 " << nfaArena.edgeNext.size();
+
+    createNFAStatusTable(result);
+    CoreDebug() << "状态转换表构建完毕";
+
+    return result;
+}
+
+/*============================输入符号的字节原子==================================*/
+
+/*
+* @brief 把NFA边上的符号划分成互不相交的字节原子
+* 变量（如 letter）和普通字符（如关键字中的 i）会包含相同的字节，
+* 直接按符号做子集构造时读入 i 只能走其中一边，关键字和标识符就不能同时匹配。
+* 所有符号的区间端点把0~255切成若干基本区间，同一基本区间内的字节被相同的符号包含；
+* 再按"被哪些符号包含"把基本区间分组，每组是一个原子，子集构造在原子上进行，
+* 每条边转移到它覆盖的所有原子上。和某个符号字节完全相同的原子沿用该符号，
+* 其余原子作为新的字符类符号加入符号表
+*/
+void LexerCompilation::splitSymbolAtoms()
+{
+    vector<int> symbols;
+    for (int sym : nfaCharSet) {
+        if (sym != EPSILON) symbols.push_back(sym);
+    }
+
+    // 基本区间 k 为 [cuts[k], cuts[k+1])
+    vector<int> cuts = {0, 256};
+    for (int sym : symbols) {
+        for (const auto& r : symbolTable[sym].ranges) {
+            cuts.push_back(r.first);
+            cuts.push_back(r.second + 1);
+        }
+    }
+    sort(cuts.begin(), cuts.end());
+    cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+
+    // 每个基本区间被哪些符号包含
+    vector<vector<int>> pieceSymbols(cuts.size() - 1);
+    for (size_t i = 0; i < symbols.size(); i++) {
+        for (const auto& r : symbolTable[symbols[i]].ranges) {
+            size_t k = lower_bound(cuts.begin(), cuts.end(), (int)r.first) - cuts.begin();
+            for (; cuts[k] <= r.second; k++) {
+                pieceSymbols[k].push_back(i);
+            }
+        }
+    }
+
+    map<vector<int>, ByteRanges> groups;
+    for (size_t k = 0; k + 1 < cuts.size(); k++) {
+        if (!pieceSymbols[k].empty()) {
+            groups[pieceSymbols[k]].push_back({cuts[k], cuts[k + 1] - 1});
+        }
+    }
+
+    dfaCharSet.clear();
+    vector<pair<int, const vector<int>*>> atoms;   // <原子, 包含它的符号>
+    for (auto& group : groups) {
+        normalizeRanges(group.second);
+        int size = rangesSize(group.second);
+        int atom = -1;
+        for (int i : group.first) {
+            if (rangesSize(symbolTable[symbols[i]].ranges) == size) {
+                atom = symbols[i];
+                break;
+            }
+        }
+        if (atom == -1) {
+            atom = rangesSymbol(group.second);
+        }
+        dfaCharSet.insert(atom);
+        atoms.push_back({atom, &group.first});
+    }
+
+    symbolAtoms.assign(symbolTable.size(), vector<int>());
+    for (const auto& a : atoms) {
+        for (int i : *a.second) {
+            symbolAtoms[symbols[i]].push_back(a.first);
+        }
+    }
+
+    CoreDebug() << "字节原子划分完毕: " << symbols.size() << " 个符号, " << cuts.size() - 1
+             << " 个基本区间, " << dfaCharSet.size() << " 个原子";
+}
+
+/*============================NFA转DFA==================================*/
+
+// 判断是否含有初态终态，含有则返回对应字符串
+string LexerCompilation::setHasStartOrEnd(const uint64_t* bits) const
+{
+    string result = "";
+    for (const int& element : startNFAstatus) {
+        if (bitsHas(bits, element)) {
+            result += "-";
+        }
+    }
+
+    for (const int& element : endNFAstatus) {
+        if (bitsHas(bits, element)) {
+            result += "+";
+            break;  // Glushkov构造有多个终态，只要一个
+        }
+    }
+
+    return result;
+}
+
+// 判断状态集合接受哪个单词，同时包含多个标记的终态时取编号小的（规则在前的优先）
+int LexerCompilation::setAcceptTag(const uint64_t* bits) const
+{
+    for (size_t i = 0; i < tagEndNFAstatus.size(); i++) {
+        for (int e : tagEndNFAstatus[i]) {
+            if (bitsHas(bits, e)) {
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+// 单词标记的显示形式，如 " ID"、" KEYWORD(if)"，非终态为空
+string LexerCompilation::tagLabel(int tag) const
+{
+    if (tag < 0) return "";
+    const AcceptTag& t = acceptTags[tag];
+    return " " + t.name + (t.text.empty() ? "" : "(" + t.text + ")");
+}
+
+// 位图转set，用于结果展示和去重
+set<int> bits2set(const StateBits& bits)
+{
+    set<int> result;
+    for (size_t w = 0; w < bits.size(); w++) {
+        uint64_t word = bits[w];
+        while (word) {
+            result.insert(result.end(), (int)(w * 64 + lowestBit(word)));
+            word &= word - 1;
+        }
+    }
+    return result;
+}
+
+/*
+* @brief 预先计算所有NFA状态的ε闭包
+* 用Tarjan算法对ε边求强连通分量（*运算产生的环缩成一个点），
+* 分量按逆拓扑序产生，产生时它能到达的分量都已算完，
+* 所以闭包 = 分量内的状态 | 各后继分量的闭包，一遍完成
+*/
+void LexerCompilation::buildEpsilonClosures()
+{
+    int n = nfaArena.stateCount;
+    const vector<int>& edgeStart = nfaArena.edgeStart;
+    const vector<int>& edgeSym = nfaArena.edgeSym;
+    const vector<int>& edgeNext = nfaArena.edgeNext;
+
+    closureWords = (n + 63) / 64;
+    closureRowOf.assign(n, -1);
+    closureBits.clear();
+
+    vector<int> index(n, -1);
+    vector<int> low(n, 0);
+    vector<char> onStack(n, 0);
+    vector<int> sccStack;
+    vector<pair<int, int>> callStack; // <状态, 下一条要看的边>
+    int counter = 0;
+    int sccCount = 0;
+
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1) continue;
+
+        index[root] = low[root] = counter++;
+        sccStack.push_back(root);
+        onStack[root] = 1;
+        callStack.push_back({root, edgeStart[root]});
+
+        while (!callStack.empty()) {
+            int v = callStack.back().first;
+            int e = callStack.back().second;
+            while (e < edgeStart[v + 1] && edgeSym[e] != EPSILON) e++;
+
+            if (e < edgeStart[v + 1]) {
+                // 沿ε边继续深入
+                callStack.back().second = e + 1;
+                int w = edgeNext[e];
+                if (index[w] == -1) {
+                    index[w] = low[w] = counter++;
+                    sccStack.push_back(w);
+                    onStack[w] = 1;
+                    callStack.push_back({w, edgeStart[w]});
+                } else if (onStack[w]) {
+                    low[v] = min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            // v 的ε边都看完了，回溯
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int parent = callStack.back().first;
+                low[parent] = min(low[parent], low[v]);
+            }
+            if (low[v] != index[v]) continue;
+
+            // v 是一个强连通分量的根，弹出整个分量并计算闭包
+            closureBits.resize((size_t)(sccCount + 1) * closureWords, 0);
+            size_t row = (size_t)sccCount * closureWords;
+            int first = sccStack.size();
+            do {
+                first--;
+            } while (sccStack[first] != v);
+            for (int i = first; i < (int)sccStack.size(); i++) {
+                int m = sccStack[i];
+                onStack[m] = 0;
+                closureRowOf[m] = sccCount;
+                closureBits[row + m / 64] |= (uint64_t)1 << (m % 64);
+            }
+            for (int i = first; i < (int)sccStack.size(); i++) {
+                int m = sccStack[i];
+                for (int k = edgeStart[m]; k < edgeStart[m + 1]; k++) {
+                    if (edgeSym[k] != EPSILON) continue;
+                    int succ = closureRowOf[edgeNext[k]];
+                    if (succ == sccCount) continue;
+                    size_t succRow = (size_t)succ * closureWords;
+                    for (int w = 0; w < closureWords; w++) {
+                        closureBits[row + w] |= closureBits[succRow + w];
+                    }
+                }
+            }
+            sccStack.resize(first);
+            sccCount++;
+        }
+    }
+
+    CoreDebug() << "ε闭包计算完毕: " << n << " 个状态, " << sccCount << " 个强连通分量";
+}
+
+// 编号为 number 的DFA状态包含的NFA状态，用于结果展示
+set<int> LexerCompilation::dfaNFAStates(int number) const
+{
+    const uint64_t* bits = dfaStateSets.get(number - 1);
+    return bits2set(StateBits(bits, bits + dfaStateSets.words));
+}
+
+// DFA状态的显示形式
+string LexerCompilation::dfaStateLabel(int number) const
+{
+    if (dfaRuleStates.empty()) {
+        return "{" + set2string(dfaNFAStates(number)) + "}";
+    }
+    const vector<int>& states = dfaRuleStates[number - 1];
+    string label = "{";
+    for (size_t i = 0; i < states.size(); i += 2) {
+        if (i > 0) label += ",";
+        label += acceptTags[states[i]].name + ":" + to_string(states[i + 1]);
+    }
+    return label + "}";
+}
+
+// DFA debug输出函数
+void LexerCompilation::printDfaTable(const vector<dfaNode>& dfaTable) const {
+    for (size_t i = 0; i < dfaTable.size(); ++i) {
+        CoreDebug() << "DFA Node " << i + 1 << " - Flag: " << dfaTable[i].flag;
+        CoreDebug() << "States: " << dfaStateLabel(i + 1);
+        CoreDebug() << "Transitions: ";
+        for (const auto& transition : dfaTable[i].transitions) {
+            CoreDebug() << "  Input: " << symbolName(transition.first) << " -> " << transition.second;
+        }
+        CoreDebug() << "---------------------";
+    }
+}
+
+/*
+* @brief DFA状态 bits 经各字节原子的转移
+* 只扫描一遍集合中NFA状态的非ε出边，目标状态的闭包按原子或到 moveBits 中，
+* moved[原子] 为true表示有转移，调用者用完后要把它清回false
+*/
+void LexerCompilation::subsetMoves(const uint64_t* bits, vector<StateBits>& moveBits, vector<bool>& moved) const
+{
+    for (int w = 0; w < closureWords; w++)
+    {
+        uint64_t word = bits[w];
+        while (word)
+        {
+            int s = w * 64 + lowestBit(word);
+            word &= word - 1;
+            for (int e = nfaArena.edgeStart[s]; e < nfaArena.edgeStart[s + 1]; e++)
+            {
+                int sym = nfaArena.edgeSym[e];
+                if (sym == EPSILON) continue;
+                // 边上的符号可能覆盖多个字节原子
+                for (int atom : symbolAtoms[sym])
+                {
+                    if (!moved[atom])
+                    {
+                        moved[atom] = true;
+                        fill(moveBits[atom].begin(), moveBits[atom].end(), 0);
+                    }
+                    orClosure(moveBits[atom], nfaArena.edgeNext[e]);
+                }
+            }
+        }
+    }
+}
+
+// 子集构造中待处理的状态超过这么多时，剩下的部分改用多个线程构造
+const int parallelSubsetFrontier = 1024;
+
+/*
+* @brief 子集构造法
+* ε闭包预先算好，每个DFA状态只扫描一遍其中NFA状态的出边，
+* 按字节原子把目标状态的闭包位图或到一起得到转移；
+* 新集合按发现顺序进入驻留表，表本身就是BFS队列，转移直接记编号。
+* 待处理的状态很多时改为多线程构造（parallelSubsets），结果和串行完全相同。
+* 状态数超过 maxStates（-1为不限）时放弃并返回false，此时只能用按需构造的DFA
+*/
+bool LexerCompilation::NFA2DFA(NFA& nfa, int maxStates)
+{
+    // 预先计算所有状态的ε闭包
+    buildEpsilonClosures();
+    dfaStateSets.reset(closureWords);
+
+    // 初态：NFA初态的ε闭包
+    StateBits startBits(closureWords, 0);
+    orClosure(startBits, nfa.start);
+    bool isNew;
+    dfaStateSets.intern(startBits.data(), isNew);
+    startStaus = 1;
+
+    // 每个字节原子的转移位图，按符号编号存放
+    vector<StateBits> moveBits(symbolTable.size(), StateBits(closureWords, 0));
+    vector<bool> moved(symbolTable.size(), false);
+    int threadCount = subsetThreads > 0 ? subsetThreads : max(1, (int)thread::hardware_concurrency());
+
+    // 对新状态进行不停遍历，编号即下标+1
+    bool complete = true;
+    for (int cur = 0; cur < dfaStateSets.size(); cur++)
+    {
+        if (maxStates >= 0 && dfaStateSets.size() > maxStates)
+        {
+            complete = false;
+            break;
+        }
+        // 待处理的状态足够多时，剩下的交给多个线程
+        if (threadCount > 1 && dfaStateSets.size() - cur > parallelSubsetFrontier)
+        {
+            complete = parallelSubsets(cur, maxStates, threadCount);
+            break;
+        }
+        const uint64_t* bits = dfaStateSets.get(cur);
+        dfaNode DFANode;
+        DFANode.flag = setHasStartOrEnd(bits);
+        DFANode.tag = setAcceptTag(bits);
+        if (DFANode.flag.find("+") != string::npos) {
+            dfaEndStatusSet.insert(cur + 1);
+        }
+        else
+        {
+            dfaNotEndStatusSet.insert(cur + 1);
+        }
+
+        // 扫描集合中所有状态的非ε出边
+        subsetMoves(bits, moveBits, moved);
+
+        // 按原子顺序处理，保证状态编号和逐个原子计算时一致
+        // （intern 可能使 pool 扩容，之后不能再用 bits）
+        for (int atom : dfaCharSet)
+        {
+            if (!moved[atom])  // 如果这个闭包是空集没必要继续下去了
+            {
+                continue;
+            }
+            moved[atom] = false;
+            DFANode.transitions[atom] = dfaStateSets.intern(moveBits[atom].data(), isNew) + 1;
+        }
+        dfaTable.push_back(DFANode);
+    }
+
+    if (!complete)
+    {
+        CoreDebug() << "DFA状态数超过 " << maxStates << "，放弃完整的子集构造";
+        dfaTable.clear();
+        dfaEndStatusSet.clear();
+        dfaNotEndStatusSet.clear();
+        dfaStateSets.reset(closureWords);
+        return false;
+    }
+
+    CoreDebug() << "子集构造完毕: " << dfaStateSets.size() << " 个DFA状态";
+
+    // dfa debug
+    // printDfaTable(dfaTable);
+    return true;
+}
+
+/*============================并行子集构造==================================*/
+
+// 并发驻留表按集合哈希值的高位分段
+const int subsetShardBits = 6;
+const int subsetShardCount = 1 << subsetShardBits;
+
+/*
+* @brief 多个线程共用的DFA状态集合驻留表
+* 每段一把锁和一个 StateSetTable，相同的集合总落在同一段，
+* 所以几个线程同时算出同一个集合时也只保存一份。
+* 临时编号为 段内下标 * 段数 + 段号；每段同时存放各状态处理后的结果，转移目标也是临时编号
+*/
+struct ConcurrentStateSets
+{
+    struct Shard
+    {
+        mutex lock;
+        StateSetTable sets;
+        vector<dfaNode> nodes;  // 下标为段内下标
+    };
+
+    int words;
+    vector<Shard> shards;
+    atomic<int> count;          // 集合总数
+
+    explicit ConcurrentStateSets(int w) : words(w), shards(subsetShardCount), count(0)
+    {
+        for (Shard& shard : shards) {
+            shard.sets.reset(w);
+        }
+    }
+
+    // 查找集合，不存在则加入；返回临时编号
+    int intern(const uint64_t* bits, bool& isNew)
+    {
+        uint64_t h = StateSetTable::hashBits(bits, words);
+        int s = (int)(h >> (64 - subsetShardBits));
+        Shard& shard = shards[s];
+        lock_guard<mutex> guard(shard.lock);
+        int local = shard.sets.intern(bits, h, isNew);
+        if (isNew) {
+            shard.nodes.emplace_back();
+            count++;
+        }
+        return local * subsetShardCount + s;
+    }
+
+    // 复制集合的位图，同一段中可能正有别的线程加入集合
+    void load(int id, StateBits& bits)
+    {
+        Shard& shard = shards[id % subsetShardCount];
+        lock_guard<mutex> guard(shard.lock);
+        const uint64_t* p = shard.sets.get(id / subsetShardCount);
+        copy(p, p + words, bits.begin());
+    }
+
+    // 记下状态处理后的结果
+    void store(int id, dfaNode& node)
+    {
+        Shard& shard = shards[id % subsetShardCount];
+        lock_guard<mutex> guard(shard.lock);
+        swap(shard.nodes[id / subsetShardCount], node);
+    }
+
+    // 以下两个只在所有线程结束后使用，不加锁
+    const uint64_t* get(int id) const
+    {
+        return shards[id % subsetShardCount].sets.get(id / subsetShardCount);
+    }
+
+    dfaNode& node(int id)
+    {
+        return shards[id % subsetShardCount].nodes[id / subsetShardCount];
+    }
+};
+
+// 一个线程的待处理状态：自己从尾部取（深度优先，位图还在缓存中），别的线程从头部偷
+struct SubsetWorkQueue
+{
+    mutex lock;
+    deque<int> items;
+
+    void push(int id)
+    {
+        lock_guard<mutex> guard(lock);
+        items.push_back(id);
+    }
+
+    bool pop(int& id)
+    {
+        lock_guard<mutex> guard(lock);
+        if (items.empty()) return false;
+        id = items.back();
+        items.pop_back();
+        return true;
+    }
+
+    bool steal(int& id)
+    {
+        lock_guard<mutex> guard(lock);
+        if (items.empty()) return false;
+        id = items.front();
+        items.pop_front();
+        return true;
+    }
+};
+
+/*
+* @brief 多线程子集构造，接着串行部分继续
+* 串行部分已处理了前 cur 个状态，驻留表中其余的状态还没处理。
+* 所有状态放入并发驻留表，未处理的平均分到各线程的队列中；每个线程取出一个状态，
+* 算出它经各原子的转移，新集合放入自己的队列，自己的队列空了就去偷别的线程的。
+* 全部处理完后从初态开始，按编号顺序处理各状态、按原子顺序给新目标编号，
+* 这正是串行算法的发现顺序，所以状态编号、dfaTable 和 dfaStateSets 都和串行构造相同。
+* 状态数超过 maxStates 时返回false
+*/
+bool LexerCompilation::parallelSubsets(int cur, int maxStates, int threadCount)
+{
+    ConcurrentStateSets table(closureWords);
+    vector<SubsetWorkQueue> queues(threadCount);
+    atomic<int> pending(0);         // 已加入还没处理完的状态数
+    atomic<bool> overflow(false);
+
+    // 串行部分得到的状态，已处理的带上结果，转移改为临时编号
+    bool isNew;
+    vector<int> seed(dfaStateSets.size());
+    for (int i = 0; i < dfaStateSets.size(); i++) {
+        seed[i] = table.intern(dfaStateSets.get(i), isNew);
+    }
+    for (int i = 0; i < cur; i++) {
+        for (auto& transition : dfaTable[i].transitions) {
+            transition.second = seed[transition.second - 1];
+        }
+        table.store(seed[i], dfaTable[i]);
+    }
+    for (int i = cur; i < (int)seed.size(); i++) {
+        queues[i % threadCount].items.push_back(seed[i]);
+    }
+    pending = (int)seed.size() - cur;
+
+    auto worker = [&](int self) {
+        vector<StateBits> moveBits(symbolTable.size(), StateBits(closureWords, 0));
+        vector<bool> moved(symbolTable.size(), false);
+        StateBits bits(closureWords);
+        int id;
+        while (!overflow) {
+            bool found = queues[self].pop(id);
+            for (int k = 1; !found && k < threadCount; k++) {
+                found = queues[(self + k) % threadCount].steal(id);
+            }
+            if (!found) {
+                if (pending == 0) break;  // 别的线程还在处理，可能还会产生新状态
+                this_thread::yield();
+                continue;
+            }
+
+            table.load(id, bits);
+            dfaNode node;
+            node.flag = setHasStartOrEnd(bits.data());
+            node.tag = setAcceptTag(bits.data());
+            subsetMoves(bits.data(), moveBits, moved);
+            for (int atom : dfaCharSet) {
+                if (!moved[atom]) continue;
+                moved[atom] = false;
+                bool added;
+                int target = table.intern(moveBits[atom].data(), added);
+                node.transitions[atom] = target;
+                if (added) {
+                    pending++;
+                    queues[self].push(target);
+                    if (maxStates >= 0 && table.count > maxStates) overflow = true;
+                }
+            }
+            table.store(id, node);
+            pending--;
+        }
+    };
+    vector<thread> workers;
+    for (int k = 0; k < threadCount; k++) {
+        workers.emplace_back(worker, k);
+    }
+    for (thread& w : workers) {
+        w.join();
+    }
+    if (overflow) {
+        return false;
+    }
+
+    // 按串行算法的发现顺序重新编号，number 按段存放，0表示还没编号
+    vector<vector<int>> number(subsetShardCount);
+    for (int s = 0; s < subsetShardCount; s++) {
+        number[s].assign(table.shards[s].sets.size(), 0);
+    }
+    vector<int> order(1, seed[0]);
+    number[seed[0] % subsetShardCount][seed[0] / subsetShardCount] = 1;
+    for (size_t i = 0; i < order.size(); i++) {
+        for (auto& transition : table.node(order[i]).transitions) {
+            int target = transition.second;
+            int& n = number[target % subsetShardCount][target / subsetShardCount];
+            if (n == 0) {
+                order.push_back(target);
+                n = order.size();
+            }
+            transition.second = n;
+        }
+    }
+
+    dfaTable.clear();
+    dfaEndStatusSet.clear();
+    dfaNotEndStatusSet.clear();
+    dfaStateSets.reset(closureWords);
+    dfaTable.reserve(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        dfaStateSets.intern(table.get(order[i]), isNew);
+        dfaNode& node = table.node(order[i]);
+        if (node.flag.find("+") != string::npos) {
+            dfaEndStatusSet.insert(i + 1);
+        } else {
+            dfaNotEndStatusSet.insert(i + 1);
+        }
+        dfaTable.push_back(move(node));
+    }
+    CoreDebug() << "并行子集构造: " << threadCount << " 个线程，串行部分处理了 " << cur << " 个状态";
+    return true;
+}
+
+/*============================按规则构造DFA==================================*/
+
+/*
+* @brief 规则语法树的规格化形式，用作规则DFA缓存的键
+* 叶结点写它的字节集合（不写显示形式），变量引用共用的子树第二次出现时只写第一次的序号，
+* 所以同一条规则每次得到相同的键，而键相同的规则一定构造出相同的DFA
+*/
+void LexerCompilation::ruleAstKey(int idx, map<int, int>& seen, string& key) const
+{
+    auto it = seen.find(idx);
+    if (it != seen.end()) {
+        key += "#" + to_string(it->second) + ";";
+        return;
+    }
+    int number = seen.size();
+    seen[idx] = number;
+
+    const RegexNode& node = regexAst[idx];
+    key += to_string((int)node.kind);
+    if (node.sym != -1) {
+        key += "[";
+        for (const auto& r : symbolTable[node.sym].ranges) {
+            key += to_string(r.first) + "-" + to_string(r.second) + ",";
+        }
+        key += "]";
+    }
+    key += "(";
+    if (node.left != -1) ruleAstKey(node.left, seen, key);
+    key += ",";
+    if (node.right != -1) ruleAstKey(node.right, seen, key);
+    key += ")";
+}
+
+// 把语法树复制到 sub 中，用到的符号在 sub 中重新编号，共用的子树只复制一次
+int LexerCompilation::copyRuleAst(int idx, LexerCompilation& sub, map<int, int>& copied) const
+{
+    auto it = copied.find(idx);
+    if (it != copied.end()) {
+        return it->second;
+    }
+    const RegexNode& node = regexAst[idx];
+    int sym = -1;
+    if (node.sym != -1) {
+        sym = sub.internSymbol(symbolTable[node.sym].name, symbolTable[node.sym].ranges);
+    }
+    int left = (node.left == -1) ? -1 : copyRuleAst(node.left, sub, copied);
+    int right = (node.right == -1) ? -1 : copyRuleAst(node.right, sub, copied);
+    int result = sub.newRegexNode(node.kind, sym, left, right);
+    copied[idx] = result;
+    return result;
+}
+
+/*
+* @brief 单独构造一条规则（单词标记 [firstTag, lastTag)）的最小化DFA
+* 在一个只含这条规则的编译中走一遍 regex2NFA、NFA2DFA、DFAminimize 和 DFAbyteClasses，
+* 状态数超过 maxStates 时返回空。不修改本对象，可以在多个线程中同时调用
+*/
+shared_ptr<RuleDFA> LexerCompilation::buildRuleDFA(size_t firstTag, size_t lastTag, int maxStates) const
+{
+    LexerCompilation sub;
+    sub.nfaConstruction = nfaConstruction;
+    sub.subsetThreads = 1;      // 已经按规则分到各个线程
+    map<int, int> copied;
+    for (size_t t = firstTag; t < lastTag; t++) {
+        sub.acceptTags.push_back(acceptTags[t]);
+        sub.tagAstRoot.push_back(copyRuleAst(tagAstRoot[t], sub, copied));
+    }
+
+    // 不忽略大小写：规则中的字母已经转成小写，合并后的DFA再统一处理大写字母
+    NFA nfa = sub.regex2NFA();
+    sub.splitSymbolAtoms();
+    if (!sub.NFA2DFA(nfa, maxStates)) {
+        return nullptr;
+    }
+    sub.DFAminimize();
+    sub.DFAbyteClasses();
+
+    shared_ptr<RuleDFA> dfa = make_shared<RuleDFA>();
+    copy(sub.byteClassMap, sub.byteClassMap + 256, dfa->classOf);
+    dfa->classCount = sub.byteClassCount;
+    dfa->start = sub.dfaMinStartState();
+    int stateNum = sub.dfaMinTable.size();
+    dfa->next.assign((size_t)stateNum * dfa->classCount, -1);
+    dfa->tag.assign(stateNum, -1);
+    for (const dfaMinNode& node : sub.dfaMinTable) {
+        dfa->tag[node.id] = node.tag;
+        copy(sub.dfaClassTable[node.id].begin(), sub.dfaClassTable[node.id].end(),
+             dfa->next.begin() + (size_t)node.id * dfa->classCount);
+    }
+    return dfa;
+}
+
+// 乘积状态（(规则, 状态) 对的序列）的哈希
+struct RuleStatesHash
+{
+    size_t operator()(const vector<int>& states) const
+    {
+        uint64_t h = 0xCBF29CE484222325ULL;
+        for (int s : states) {
+            h = (h ^ (uint32_t)s) * 0x100000001B3ULL;
+        }
+        return h;
+    }
+};
+
+/*
+* @brief 按规则构造DFA
+* 1. 每条规则单独构造最小化DFA（buildRuleDFA），没有缓存的规则分给多个线程，线程从计数器领取规则；
+* 2. 乘积构造：DFA状态是各规则DFA当前状态的组合，只记还没有死掉的规则，
+*    按全局的字节原子求转移，原子中的字节在每条规则的DFA中都属于同一个等价类，取第一个字节查表；
+*    终态接受的单词取编号最小的标记，和子集构造中前面的规则优先相同；
+* 3. 之后照常 DFAminimize，最小化DFA和子集构造的结果相同（只是状态编号可能不同）。
+* 修改一条规则时只有这条规则的DFA需要重新构造，但乘积构造和最小化仍然针对全部规则。
+* NFA仍要先由 regex2NFA、splitSymbolAtoms 构造好，ε闭包也照常计算，供查看NFA和按需构造的DFA使用
+*/
+bool LexerCompilation::rules2DFA(RuleDFACache* cache, int maxStates)
+{
+    buildEpsilonClosures();
+    dfaStateSets.reset(closureWords);
+    dfaRuleStates.clear();
+
+    // 每条规则的单词标记是 acceptTags 中连续的一段 [firstTag[r], firstTag[r + 1])，多单词规则每个分支一个
+    size_t ruleCount = regexToGenerate.size();
+    vector<size_t> firstTag(ruleCount + 1, acceptTags.size());
+    for (size_t r = 0; r < ruleCount; r++) {
+        firstTag[r] = regexToGenerate[r].firstTag;
+    }
+
+    vector<string> keys(ruleCount);
+    vector<shared_ptr<const RuleDFA>> rules(ruleCount);
+    vector<size_t> missing;
+    for (size_t r = 0; r < ruleCount; r++) {
+        map<int, int> seen;
+        for (size_t t = firstTag[r]; t < firstTag[r + 1]; t++) {
+            ruleAstKey(tagAstRoot[t], seen, keys[r]);
+            keys[r] += ";";
+        }
+        if (cache) rules[r] = cache->find(keys[r]);
+        if (!rules[r]) missing.push_back(r);
+    }
+    ruleDFAsBuilt = missing.size();
+    ruleDFAsReused = ruleCount - missing.size();
+
+    int threadCount = subsetThreads > 0 ? subsetThreads : max(1, (int)thread::hardware_concurrency());
+    threadCount = min(threadCount, (int)missing.size());
+    atomic<size_t> nextRule(0);
+    atomic<bool> tooLarge(false);
+    auto worker = [&]() {
+        for (size_t k = nextRule++; k < missing.size() && !tooLarge; k = nextRule++) {
+            size_t r = missing[k];
+            shared_ptr<RuleDFA> dfa = buildRuleDFA(firstTag[r], firstTag[r + 1], maxStates);
+            if (!dfa) {
+                tooLarge = true;
+                break;
+            }
+            rules[r] = dfa;
+        }
+    };
+    vector<thread> workers;
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (thread& t : workers) {
+        t.join();
+    }
+    if (tooLarge) {
+        CoreDebug() << "规则的DFA状态数超过 " << maxStates << "，放弃按规则构造";
+        return false;
+    }
+    if (cache) {
+        for (size_t r : missing) {
+            cache->insert(keys[r], rules[r]);
+        }
+        cache->retain(set<string>(keys.begin(), keys.end()));
+    }
+    CoreDebug() << "规则DFA: 重新构造 " << ruleDFAsBuilt << " 条，使用缓存 " << ruleDFAsReused << " 条";
+
+    // 乘积状态中的规则用它的第一个单词标记表示，规则DFA的接受标记加上它就是 acceptTags 下标
+    vector<const RuleDFA*> ruleAt(acceptTags.size(), nullptr);
+    for (size_t r = 0; r < ruleCount; r++) {
+        ruleAt[firstTag[r]] = rules[r].get();
+    }
+
+    // 每个原子在各规则DFA中的等价类
+    vector<int> atoms(dfaCharSet.begin(), dfaCharSet.end());
+    vector<vector<int>> atomClass(acceptTags.size());
+    for (size_t r = 0; r < ruleCount; r++) {
+        for (int atom : atoms) {
+            atomClass[firstTag[r]].push_back(rules[r]->classOf[symbolTable[atom].ranges.front().first]);
+        }
+    }
+
+    // 乘积构造，dfaRuleStates 本身就是BFS队列，编号即下标+1
+    unordered_map<vector<int>, int, RuleStatesHash> stateIndex;
+    vector<int> start;
+    for (size_t r = 0; r < ruleCount; r++) {
+        start.push_back(firstTag[r]);
+        start.push_back(rules[r]->start);
+    }
+    stateIndex[start] = 0;
+    dfaRuleStates.push_back(start);
+    startStaus = 1;
+
+    bool complete = true;
+    vector<int> target;
+    for (size_t cur = 0; cur < dfaRuleStates.size(); cur++)
+    {
+        if (maxStates >= 0 && (int)dfaRuleStates.size() > maxStates)
+        {
+            complete = false;
+            break;
+        }
+        vector<int> states = dfaRuleStates[cur];
+        dfaNode DFANode;
+        DFANode.flag = (cur == 0) ? "-" : "";
+        for (size_t i = 0; i < states.size(); i += 2) {
+            int tag = ruleAt[states[i]]->tag[states[i + 1]];
+            if (tag != -1 && (DFANode.tag == -1 || states[i] + tag < DFANode.tag)) {
+                DFANode.tag = states[i] + tag;
+            }
+        }
+        if (DFANode.tag != -1) {
+            DFANode.flag += "+";
+            dfaEndStatusSet.insert(cur + 1);
+        } else {
+            dfaNotEndStatusSet.insert(cur + 1);
+        }
+
+        for (size_t a = 0; a < atoms.size(); a++) {
+            target.clear();
+            for (size_t i = 0; i < states.size(); i += 2) {
+                const RuleDFA& rule = *ruleAt[states[i]];
+                int next = rule.next[(size_t)states[i + 1] * rule.classCount + atomClass[states[i]][a]];
+                if (next != -1) {
+                    target.push_back(states[i]);
+                    target.push_back(next);
+                }
+            }
+            if (target.empty()) continue;
+            auto found = stateIndex.insert({target, (int)dfaRuleStates.size()});
+            if (found.second) {
+                dfaRuleStates.push_back(target);
+            }
+            DFANode.transitions[atoms[a]] = found.first->second + 1;
+        }
+        dfaTable.push_back(DFANode);
+    }
+
+    if (!complete)
+    {
+        CoreDebug() << "DFA状态数超过 " << maxStates << "，放弃按规则构造";
+        dfaTable.clear();
+        dfaEndStatusSet.clear();
+        dfaNotEndStatusSet.clear();
+        dfaRuleStates.clear();
+        return false;
+    }
+
+    CoreDebug() << "乘积构造完毕: " << ruleCount << " 条规则，" << dfaTable.size() << " 个DFA状态";
+    return true;
+}
+
+/*
+* @brief 可细分的划分：各块的状态在 elems 中连续存放
+* 块 b 占 [first[b], end[b])，其中 [first[b], marked[b]) 是本轮被标记的状态
+*/
+struct Partition
+{
+    vector<int> elems;   // 按块排列的状态
+    vector<int> loc;     // 状态在 elems 中的位置
+    vector<int> blockOf; // 状态所在块
+    vector<int> first, end, marked;
+
+    int blockCount() const
+    {
+        return (int)first.size();
+    }
+
+    // 按 key 分组建立初始划分，key 相同的状态在同一块，块按 key 从小到大编号
+    void init(const vector<int>& key)
+    {
+        int n = key.size();
+        vector<int> order(n);
+        for (int s = 0; s < n; s++) order[s] = s;
+        stable_sort(order.begin(), order.end(), [&](int x, int y) { return key[x] < key[y]; });
+
+        elems = order;
+        loc.assign(n, 0);
+        blockOf.assign(n, 0);
+        first.clear();
+        end.clear();
+        marked.clear();
+        for (int i = 0; i < n; i++) {
+            int s = elems[i];
+            if (i == 0 || key[s] != key[elems[i - 1]]) {
+                if (i > 0) end.push_back(i);
+                first.push_back(i);
+                marked.push_back(i);
+            }
+            loc[s] = i;
+            blockOf[s] = first.size() - 1;
+        }
+        if (n > 0) end.push_back(n);
+    }
+
+    // 标记状态s（换到所在块的已标记区），返回该块是否是本轮第一次被标记
+    bool mark(int s)
+    {
+        int b = blockOf[s];
+        int pos = loc[s];
+        int m = marked[b];
+        if (pos < m) return false;
+        int other = elems[m];
+        elems[m] = s;
+        loc[s] = m;
+        elems[pos] = other;
+        loc[other] = pos;
+        marked[b]++;
+        return m == first[b];
+    }
+
+    // 把块b的已标记部分分成新块，返回新块下标；全部被标记时不分割，返回-1
+    int split(int b)
+    {
+        int mid = marked[b];
+        marked[b] = first[b];
+        if (mid == end[b]) return -1;
+
+        int nb = blockCount();
+        first.push_back(first[b]);
+        end.push_back(mid);
+        marked.push_back(first[b]);
+        first[b] = mid;
+        marked[b] = mid;
+        for (int i = first[nb]; i < end[nb]; i++) {
+            blockOf[elems[i]] = nb;
+        }
+        return nb;
+    }
+};
+
+/*
+* @brief Hopcroft算法最小化DFA
+* 缺失的转移补到一个死状态上，使DFA完整；初始划分为 死状态 / 非终态 / 每个单词标记的终态各一块，
+* 不同单词的终态不能合并。每次从工作表中取出分割者(块B, 字符c)，
+* 沿反向转移标记所有经c进入B的状态，把被部分标记的块一分为二，
+* 再按Hopcroft的规则只把较小的一半放入工作表，总代价 O(n·k·log n)
+*/
+void LexerCompilation::DFAminimize()
+{
+    int n = dfaTable.size();
+    int k = dfaCharSet.size();
+    int total = n + 1;  // 状态 n 为补上的死状态
+
+    // 符号 -> 列号
+    vector<int> symIndex(symbolTable.size(), -1);
+    vector<int> alphabet;
+    for (int atom : dfaCharSet) {
+        symIndex[atom] = alphabet.size();
+        alphabet.push_back(atom);
+    }
+
+    // 整数转移表（状态从0开始），缺失的转移指向死状态
+    vector<int> delta((size_t)total * k, n);
+    for (int s = 0; s < n; s++) {
+        for (const auto& t : dfaTable[s].transitions) {
+            delta[(size_t)s * k + symIndex[t.first]] = t.second - 1;
+        }
+    }
+
+    // 反向转移：按 (目标状态, 字符) 分组的前驱表
+    vector<int> invStart((size_t)total * k + 1, 0);
+    for (size_t e = 0; e < delta.size(); e++) {
+        invStart[(size_t)delta[e] * k + e % k + 1]++;
+    }
+    for (size_t i = 1; i < invStart.size(); i++) {
+        invStart[i] += invStart[i - 1];
+    }
+    vector<int> invList(delta.size());
+    {
+        vector<int> fillPos(invStart.begin(), invStart.end() - 1);
+        for (size_t e = 0; e < delta.size(); e++) {
+            invList[fillPos[(size_t)delta[e] * k + e % k]++] = e / k;
+        }
+    }
+
+    // 初始划分：死状态 / 非终态 / 按单词标记分组的终态
+    vector<int> key(total);
+    for (int s = 0; s < n; s++) {
+        key[s] = dfaEndStatusSet.count(s + 1) ? dfaTable[s].tag + 1 : 0;
+    }
+    key[n] = -1;
+    Partition P;
+    P.init(key);
+
+    // 工作表：初始时除最大块外的所有块与每个字符
+    vector<pair<int, int>> worklist;
+    vector<char> inWorklist((size_t)P.blockCount() * k, 0);
+    int largest = 0;
+    for (int b = 1; b < P.blockCount(); b++) {
+        if (P.end[b] - P.first[b] > P.end[largest] - P.first[largest]) largest = b;
+    }
+    for (int b = 0; b < P.blockCount(); b++) {
+        if (b == largest) continue;
+        for (int c = 0; c < k; c++) {
+            worklist.push_back({b, c});
+            inWorklist[(size_t)b * k + c] = 1;
+        }
+    }
+
+    vector<int> splitter;
+    vector<int> touched;
+    while (!worklist.empty())
+    {
+        int B = worklist.back().first;
+        int c = worklist.back().second;
+        worklist.pop_back();
+        inWorklist[(size_t)B * k + c] = 0;
+
+        // 先拷出B的状态，标记时块内顺序会变
+        splitter.assign(P.elems.begin() + P.first[B], P.elems.begin() + P.end[B]);
+        touched.clear();
+        for (int t : splitter) {
+            size_t row = (size_t)t * k + c;
+            for (int i = invStart[row]; i < invStart[row + 1]; i++) {
+                if (P.mark(invList[i])) touched.push_back(P.blockOf[invList[i]]);
+            }
+        }
+
+        for (int X : touched) {
+            int Y = P.split(X);
+            if (Y == -1) continue;
+            inWorklist.resize((size_t)P.blockCount() * k, 0);
+            int smaller = (P.end[Y] - P.first[Y] <= P.end[X] - P.first[X]) ? Y : X;
+            for (int a = 0; a < k; a++) {
+                // X已在工作表中时两半都要处理，否则只处理较小的一半
+                int add = inWorklist[(size_t)X * k + a] ? Y : smaller;
+                if (!inWorklist[(size_t)add * k + a]) {
+                    inWorklist[(size_t)add * k + a] = 1;
+                    worklist.push_back({add, a});
+                }
+            }
+        }
+    }
+
+    // 按块中最小的DFA状态编号给块编号，初态所在块总是0号
+    vector<int> blockId(P.blockCount(), -1);
+    vector<int> blockRep;
+    for (int s = 0; s < n; s++) {
+        int b = P.blockOf[s];
+        if (blockId[b] == -1) {
+            blockId[b] = blockRep.size();
+            blockRep.push_back(s);
+        }
+    }
+    dfaMinMap.assign(n + 1, -1);
+    for (int s = 0; s < n; s++) {
+        dfaMinMap[s + 1] = blockId[P.blockOf[s]];
+    }
+
+    for (int id = 0; id < (int)blockRep.size(); id++)
+    {
+        int rep = blockRep[id];
+        dfaMinNode d;
+        d.id = id;
+        if (P.blockOf[rep] == P.blockOf[startStaus - 1]) {
+            d.flag += "-";
+        }
+        if (dfaEndStatusSet.count(rep + 1)) {
+            d.flag += "+";
+        }
+        d.tag = dfaTable[rep].tag;
+        // 逐个字符，转到死状态记为-1
+        for (int c = 0; c < k; c++)
+        {
+            int next_state = delta[(size_t)rep * k + c];
+            d.transitions[alphabet[c]] = next_state == n ? -1 : dfaMinMap[next_state + 1];
+        }
+        dfaMinTable.push_back(d);
+    }
+
+    CoreDebug() << "DFA最小化完成！" << n << " -> " << dfaMinTable.size() << " 个状态";
+}
+
+/*============================DFA字符等价类==================================*/
+
+/*
+* @brief 把最小化DFA展开成按字节的转移行
+* 每个状态256列，字节原子展开为它包含的字节（原子互不相交）
+*/
+vector<vector<int>> LexerCompilation::dfaMinByteRows() const
+{
+    vector<vector<int>> rows(dfaMinTable.size(), vector<int>(256, -1));
+    for (const dfaMinNode& node : dfaMinTable) {
+        vector<int>& row = rows[node.id];
+        for (const auto& entry : node.transitions) {
+            if (entry.second == -1) continue;
+            for (const auto& r : symbolTable[entry.first].ranges) {
+                fill(row.begin() + r.first, row.begin() + r.second + 1, entry.second);
+            }
+        }
+        // 忽略大小写时大写字母按对应小写字母转移
+        if (isLowerCase) {
+            for (int c = 'A'; c <= 'Z'; c++) {
+                if (row[c] == -1) row[c] = row[tolower(c)];
+            }
+        }
+    }
+    return rows;
+}
+
+/*
+* @brief 计算字节等价类
+* 在DFA最小化之后运行：两个字节在所有状态下转移都相同则属于同一等价类，
+* 如 letter 只作为整体使用时 [A-Za-z] 就是一个等价类。
+* 结果为256项的 byteClassMap 和 状态数×等价类数 的 dfaClassTable
+*/
+void LexerCompilation::DFAbyteClasses()
+{
+    vector<vector<int>> rows = dfaMinByteRows();
+    int stateNum = rows.size();
+
+    // 以字节所在的列（各状态下的转移）为键划分，按字节出现顺序编号
+    map<vector<int>, int> columnClass;
+    vector<int> column(stateNum);
+    byteClassCount = 0;
+    dfaClassTable.assign(stateNum, vector<int>());
+    for (int b = 0; b < 256; b++) {
+        for (int s = 0; s < stateNum; s++) {
+            column[s] = rows[s][b];
+        }
+        auto it = columnClass.find(column);
+        if (it == columnClass.end()) {
+            it = columnClass.insert({column, byteClassCount++}).first;
+            for (int s = 0; s < stateNum; s++) {
+                dfaClassTable[s].push_back(column[s]);
+            }
+        }
+        byteClassMap[b] = it->second;
+    }
+
+    CoreDebug() << "字节等价类: " << byteClassCount << " 个，转移表 "
+             << stateNum * 256 << " 项压缩为 " << stateNum * byteClassCount << " 项";
+}
+
+/*============================自环状态加速==================================*/
+
+/*
+* @brief 找出最小化DFA中可以加速的自环状态
+* 标识符、数字串这类状态在一大类字节上转回自己，扫描时一次跳过整段这样的字节，
+* 不必每个字节查一次转移表。rows 为 dfaMinByteRows 的结果，返回每个状态转回自己的字节区间，
+* 没有自环或区间超过 selfLoopMaxRanges 个的状态为空，不加速
+*/
+vector<ByteRanges> selfLoopRanges(const vector<vector<int>>& rows)
+{
+    vector<ByteRanges> loops(rows.size());
+    for (size_t s = 0; s < rows.size(); s++) {
+        ByteRanges ranges;
+        for (int b = 0; b < 256; b++) {
+            if (rows[s][b] != (int)s) continue;
+            if (!ranges.empty() && ranges.back().second == b - 1) {
+                ranges.back().second = b;
+            } else {
+                ranges.push_back({(unsigned char)b, (unsigned char)b});
+            }
+        }
+        if ((int)ranges.size() <= selfLoopMaxRanges) {
+            loops[s] = ranges;
+        }
+    }
+    return loops;
+}
+
+// 最小化DFA的初态，标志中带 - 的状态
+int LexerCompilation::dfaMinStartState() const
+{
+    for (const dfaMinNode& node : dfaMinTable) {
+        if (node.flag.find("-") != string::npos) {
+            return node.id;
+        }
+    }
+    return 0;
+}
+
+// 字节的C字符常量，可见字符写成 'a'，其他写成十六进制数
+string cCharLiteral(unsigned char c)
+{
+    if (c > ' ' && c < 127 && c != '\'' && c != '\\') {
+        return "\'" + string(1, (char)c) + "\'";
+    }
+    char hex[8];
+    snprintf(hex, sizeof(hex), "0x%X", c);
+    return hex;
+}
+
+/*
+* @brief 辅助函数：根据变量（字符集合）包含的字节区间生成 case 语句
+* 每个区间一个 case，多于一个字节的区间用GCC的 case 'a' ... 'z': 写法，[0-9] 只有一条
+*/
+void generateCasesForVarDef(const ByteRanges& ranges, string& codeStr)
+{
+    for (const auto& r : ranges) {
+        codeStr += "        case " + cCharLiteral(r.first);
+        if (r.second != r.first) {
+            codeStr += " ... " + cCharLiteral(r.second);
+        }
+        codeStr += ":\n";
+    }
+}
+
+/*
+* @brief 生成自环状态的跳过函数 yy_skip_N
+* 有SSE2时用 YY_IN_RANGE 每次检查16个字节，剩下的逐字节比较；
+* 没有可加速的状态时返回空串
+*/
+string generateSelfLoopSkippers(const vector<ByteRanges>& loops)
+{
+    string code;
+    for (size_t s = 0; s < loops.size(); s++) {
+        const ByteRanges& ranges = loops[s];
+        if (ranges.empty()) continue;
+
+        code += "// State " + to_string((int)s) + " loops on " + rangesDisplay(ranges) + "\n";
+        code += "static const char* yy_skip_" + to_string((int)s) + "(const char* p) {\n";
+        code += "#ifdef YY_SSE2\n";
+        code += "    while (yy_end - p >= 16) {\n";
+        code += "        __m128i x = _mm_loadu_si128((const __m128i*)p);\n";
+        for (size_t i = 0; i < ranges.size(); i++) {
+            string test = "YY_IN_RANGE(x, " + cCharLiteral(ranges[i].first) + ", " + cCharLiteral(ranges[i].second) + ")";
+            code += (i == 0) ? "        __m128i in = " + test + ";\n"
+                             : "        in = _mm_or_si128(in, " + test + ");\n";
+        }
+        code += "        unsigned out = ~(unsigned)_mm_movemask_epi8(in) & 0xFFFF;\n";
+        code += "        if (out != 0) return p + __builtin_ctz(out);\n";
+        code += "        p += 16;\n";
+        code += "    }\n";
+        code += "#endif\n";
+        code += "    while (p < yy_end && (";
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (i > 0) code += " || ";
+            code += "YY_BYTE_IN(*p, " + cCharLiteral(ranges[i].first) + ", " + cCharLiteral(ranges[i].second) + ")";
+        }
+        code += ")) p++;\n";
+        code += "    return p;\n";
+        code += "}\n\n";
+    }
+    if (code.empty()) {
+        return code;
+    }
+
+    return R"(// Self-loop states skip whole runs of the bytes they loop on, 16 at a time with SSE2
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define YY_SSE2 1
+// Bytes of x in [lo, hi]: x - lo <= hi - lo as unsigned bytes
+#define YY_IN_RANGE(x, lo, hi) _mm_cmpeq_epi8(_mm_min_epu8(_mm_sub_epi8(x, _mm_set1_epi8((char)(lo))), \
+    _mm_set1_epi8((char)((hi) - (lo)))), _mm_sub_epi8(x, _mm_set1_epi8((char)(lo))))
+#endif
+#define YY_BYTE_IN(c, lo, hi) ((unsigned char)((c) - (lo)) <= (unsigned char)((hi) - (lo)))
+
+)" + code;
+}
+
+/*
+* @brief 为最小化DFA的一个状态生成 switch 中的 case 语句
+* row 为该状态按字节的转移行，转到同一状态的字节合成字节区间，每个目标状态一组 case，
+* 组内各区间由 generateCasesForVarDef 生成，最后跳到目标状态的代码
+*/
+void genLexCase(const vector<int>& row, string& codeStr)
+{
+    // 目标状态 -> 字节区间，按目标第一次出现的字节排列
+    vector<int> targets;
+    map<int, ByteRanges> targetRanges;
+    for (int b = 0; b < 256; b++) {
+        int target = row[b];
+        if (target == -1) continue;
+        ByteRanges& ranges = targetRanges[target];
+        if (ranges.empty()) {
+            targets.push_back(target);
+        }
+        if (!ranges.empty() && ranges.back().second == b - 1) {
+            ranges.back().second = b;
+        } else {
+            ranges.push_back({(unsigned char)b, (unsigned char)b});
+        }
+    }
+
+    for (int target : targets) {
+        generateCasesForVarDef(targetRanges[target], codeStr);
+        codeStr += "            goto yy_state_" + to_string(target) + ";\n";
+    }
+}
+
+/*
+* @brief 生成直接编码的 yy_match
+* 最小化DFA的每个状态是一段带标号的代码：终态先记下当前的最长匹配，
+* 再读入一个字节，用 genLexCase 生成的 switch 跳到下一个状态，没有转移时结束匹配。
+* 和re2c的做法相同，不查转移表，适合TINY、Mini-C这样状态不多的DFA；自环状态进入时先跳过整段自环字节。
+* 输入末尾的 '\0' 哨兵在大多数状态下没有转移，只有 '\0' 上有转移的状态才需要检查是否到了末尾
+*/
+string LexerCompilation::generateDirectMatch(int startState) const
+{
+    vector<vector<int>> rows = dfaMinByteRows();
+    vector<ByteRanges> loops = selfLoopRanges(rows);
+
+    string code = generateSelfLoopSkippers(loops);
+    code += "// Run the DFA over the input at p; returns the tag of the longest match (its length in *matchLen),\n"
+                   "// -1 if none. Each state is a labelled block, the byte is dispatched by a switch\n";
+    code += "static int yy_match(const char* p, size_t* matchLen) {\n";
+    code += "    const char* start = p;\n";
+    code += "    const char* last = p;\n";
+    code += "    int lastTag = -1;\n";
+    code += "    goto yy_state_" + to_string(startState) + ";\n";
+
+    for (const dfaMinNode& node : dfaMinTable) {
+        code += "\nyy_state_" + to_string(node.id) + ":\n";
+        // 初态是开始匹配的地方，不是读入字节后到达的，只在转回自己时跳过
+        if (!loops[node.id].empty() && node.id != startState) {
+            code += "    p = yy_skip_" + to_string(node.id) + "(p);\n";
+        }
+        if (node.tag >= 0) {
+            // 和表驱动一样不接受空串：初态只有读入字符后再回到这里时才记下匹配
+            code += (node.id == startState) ? "    if (p != start) { " : "    ";
+            code += "lastTag = " + to_string(node.tag) + "; last = p;";
+            code += (node.id == startState) ? " }\n" : "\n";
+        }
+        const vector<int>& row = rows[node.id];
+        if (count(row.begin(), row.end(), -1) == 256) {
+            code += "    goto yy_done;\n";
+            continue;
+        }
+        if (row[0] != -1) {
+            code += "    if (p == yy_end) goto yy_done;\n";
+        }
+        code += "    switch ((unsigned char)*p++) {\n";
+        genLexCase(row, code);
+        code += "        default:\n";
+        code += "            goto yy_done;\n";
+        code += "    }\n";
+    }
+
+    code += R"(
+yy_done:
+    *matchLen = last - start;
+    return lastTag;
+}
+
+)";
+    return code;
+}
+
+const LexLangProfile tinyProfile = {
+    "TINY",
+    "",
+    {"{", "}"}
+};
+
+const LexLangProfile miniCProfile = {
+    "Mini-C",
+    "//",
+    {"", ""}
+};
+
+// 词法分析结果文件头，Mini-C的文件头带语言名，SLR1分析器据此识别语言
+string lexHeader(const string& language)
+{
+    return language == "TINY" ? "=== Lexical Analysis Results ==="
+                              : "=== " + language + " Lexical Analysis Results ===";
+}
+
+// 把字符串转成C字符串字面量，控制字符写成八进制转义，UTF-8字节原样保留
+string cStringLiteral(const string& str)
+{
+    string result = "\"";
+    for (char c : str) {
+        unsigned char b = c;
+        if (c == '\\' || c == '"') {
+            result += '\\';
+            result += c;
+        } else if (b < ' ' || b == 127) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\%03o", b);
+            result += esc;
+        } else {
+            result += c;
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+// 生成 const char* 数组
+string cStringArray(const string& name, const vector<string>& items)
+{
+    string code = "static const char* const " + name + "[] = {";
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i > 0) code += ", ";
+        code += cStringLiteral(items[i]);
+    }
+    if (items.empty()) code += "0";
+    code += "};\n";
+    code += "#define " + asciiUpper(name) + "_COUNT " + to_string((int)items.size()) + "\n";
+    return code;
+}
+
+/*
+* @brief 由最小化DFA生成词法分析程序
+* 表驱动时输入字节先经 yy_class 映射为等价类，再查 yy_next[状态][等价类] 转移表，
+* yy_accept 为每个状态接受的单词标记。两张表的元素类型按状态数和标记数选择：状态数不到 0xFFFF 时用 uint16_t，
+* 否则用 uint32_t，死状态 YY_DEAD 总是该类型的最大值，不会和状态编号重合；直接编码时由 generateDirectMatch 把状态生成为代码。
+* 驱动循环按最长匹配原则识别单词，单词类别和编码直接由标记查表得到
+*/
+string LexerCompilation::generateLexer(int langIndex, LexerBackend backend) const
+{
+    const LexLangProfile& profile = (langIndex == 0) ? tinyProfile : miniCProfile;
+    int stateNum = dfaMinTable.size();
+
+    int startState = dfaMinStartState();
+
+    // 状态编号要能放进 yy_next 的元素，并且不能等于 YY_DEAD
+    bool wideStates = stateNum >= 0xFFFF;
+
+    // '\0' 哨兵上有转移时，表驱动的匹配循环需要检查是否到了输入末尾
+    bool nulMoves = false;
+    for (int s = 0; s < stateNum; s++) {
+        if (dfaClassTable[s][byteClassMap[0]] != -1) nulMoves = true;
+    }
+
+    vector<string> tokenNames;
+    vector<string> tokenTexts;
+    vector<int> tokenCodes;
+    for (const AcceptTag& tag : acceptTags) {
+        tokenNames.push_back(tag.name);
+        tokenTexts.push_back(tag.text);
+        tokenCodes.push_back(tag.code);
+    }
+
+    string lexCode;
+    lexCode += R"(#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+)";
+
+    // DFA表
+    lexCode += "// Minimized DFA: " + to_string(stateNum) + " states" +
+               (backend == LEXER_DIRECT ? ", direct-coded\n\n" : "\n");
+    if (backend == LEXER_TABLE) {
+        lexCode += "#define YY_NUM_STATES " + to_string(stateNum) + "\n";
+        lexCode += "#define YY_NUM_CLASSES " + to_string(byteClassCount) + "\n";
+        lexCode += "#define YY_START " + to_string(startState) + "\n";
+        lexCode += string("#define YY_DEAD ") + (wideStates ? "0xFFFFFFFFu" : "0xFFFF") + "\n\n";
+
+        lexCode += "// Equivalence class of each input byte\n";
+        lexCode += "static const uint8_t yy_class[256] = {";
+        for (int b = 0; b < 256; b++) {
+            if (b % 32 == 0) lexCode += "\n    ";
+            lexCode += to_string(byteClassMap[b]);
+            if (b != 255) lexCode += ",";
+        }
+        lexCode += "\n};\n\n";
+
+        lexCode += "// Next state for each (state, byte class)\n";
+        lexCode += string("static const ") + (wideStates ? "uint32_t" : "uint16_t") +
+                   " yy_next[YY_NUM_STATES][YY_NUM_CLASSES] = {\n";
+        for (int s = 0; s < stateNum; s++) {
+            lexCode += "    {";
+            for (int k = 0; k < byteClassCount; k++) {
+                if (k > 0) lexCode += ", ";
+                lexCode += (dfaClassTable[s][k] == -1) ? string("YY_DEAD") : to_string(dfaClassTable[s][k]);
+            }
+            lexCode += "},\n";
+        }
+        lexCode += "};\n\n";
+
+        lexCode += "// Token tag accepted in each state, -1 if not accepting\n";
+        lexCode += string("static const ") + (acceptTags.size() > 0x7FFF ? "int32_t" : "int16_t") +
+                   " yy_accept[YY_NUM_STATES] = {";
+        for (int s = 0; s < stateNum; s++) {
+            if (s % 16 == 0) lexCode += "\n    ";
+            lexCode += to_string(dfaMinTable[s].tag);
+            if (s != stateNum - 1) lexCode += ", ";
+        }
+        lexCode += "\n};\n\n";
+    }
+
+    lexCode += "// Token name, fixed spelling (empty: use the matched text) and code of each tag\n";
+    lexCode += cStringArray("yy_token_name", tokenNames);
+    lexCode += cStringArray("yy_token_text", tokenTexts);
+    lexCode += "static const int yy_token_code[] = {";
+    for (size_t i = 0; i < tokenCodes.size(); i++) {
+        if (i > 0) lexCode += ", ";
+        lexCode += to_string(tokenCodes[i]);
+    }
+    if (tokenCodes.empty()) lexCode += "0";
+    lexCode += "};\n\n";
+
+    // 语言补充信息
+    lexCode += "// " + profile.name + " comments\n";
+    lexCode += "static const char* const yy_line_comment = " + cStringLiteral(profile.lineComment) + ";\n";
+    lexCode += "static const char* const yy_block_comment[2] = {" + cStringLiteral(profile.blockComment[0]) +
+               ", " + cStringLiteral(profile.blockComment[1]) + "};\n";
+    lexCode += "static const char* const yy_header = " + cStringLiteral(lexHeader(profile.name)) + ";\n";
+    lexCode += "static const char* const yy_language = " + cStringLiteral(profile.name) + ";\n\n";
+
+    lexCode += R"(// Token counter
+int tokenCount = 0;
+
+// End of the input; the byte at yy_end is a '\0' sentinel
+static const char* yy_end;
+
+// Check whether the input at p starts with str
+static int yy_startsWith(const char* p, const char* str) {
+    size_t n = strlen(str);
+    return n > 0 && (size_t)(yy_end - p) >= n && memcmp(p, str, n) == 0;
+}
+
+)";
+
+    if (backend == LEXER_DIRECT) {
+        lexCode += generateDirectMatch(startState);
+    } else {
+        // 自环状态的跳过函数表
+        vector<ByteRanges> loops = selfLoopRanges(dfaMinByteRows());
+        string skippers = generateSelfLoopSkippers(loops);
+        lexCode += skippers;
+        if (!skippers.empty()) {
+            lexCode += "// Self-loop skipper of each state, NULL if the state is not accelerated\n";
+            lexCode += "static const char* (*const yy_skip[YY_NUM_STATES])(const char*) = {";
+            for (int s = 0; s < stateNum; s++) {
+                if (s % 8 == 0) lexCode += "\n    ";
+                lexCode += loops[s].empty() ? string("NULL") : "yy_skip_" + to_string(s);
+                if (s != stateNum - 1) lexCode += ", ";
+            }
+            lexCode += "\n};\n\n";
+        }
+
+        lexCode += R"(// Run the DFA over the input at p; returns the tag of the longest match (its length in *matchLen),
+// -1 if none. The '\0' sentinel after the input stops the loop without a bounds check
+static int yy_match(const char* p, size_t* matchLen) {
+    const char* start = p;
+    const char* last = p;
+    unsigned state = YY_START;
+    int lastTag = -1;
+    for (;;) {
+        unsigned char c = (unsigned char)*p;
+        state = yy_next[state][yy_class[c]];
+)";
+        lexCode += nulMoves ? "        if (state == YY_DEAD || (c == 0 && p == yy_end)) break;\n"
+                            : "        if (state == YY_DEAD) break;\n";
+        lexCode += "        p++;\n";
+        if (!skippers.empty()) {
+            lexCode += "        if (yy_skip[state] != NULL) p = yy_skip[state](p);\n";
+        }
+        lexCode += R"(        if (yy_accept[state] >= 0) {
+            lastTag = yy_accept[state];
+            last = p;
+        }
+    }
+    *matchLen = last - start;
+    return lastTag;
+}
+
+)";
+    }
+
+    lexCode += R"(// Binary token file (.lexb): header, token types, token records, then the string pool.
+// All integers are little-endian uint32_t; the pool starts with the whole input, so token
+// records point straight into the source text and are read back without any parsing
+typedef struct {
+    char magic[4];          // "LEXB"
+    uint32_t version;       // 1
+    uint32_t typeCount;
+    uint32_t tokenCount;
+    uint32_t poolSize;
+    char language[12];
+} yy_lexb_header;
+
+typedef struct {
+    uint32_t code, nameOffset, nameLength;
+} yy_lexb_type;
+
+typedef struct {
+    uint32_t code, offset, length, line;
+} yy_lexb_token;
+
+static yy_lexb_token* yy_tokens;
+static size_t yy_tokenCap;
+
+// Text mode (-t): write the readable "n: TYPE, value" lines instead of the binary file
+static int yy_textMode = 0;
+
+// Output a token in text mode; value is a slice of the input (not NUL-terminated)
+void outputToken(FILE* fp, const char* typeName, const char* value, size_t len) {
+    fprintf(fp, "%d: %s, ", tokenCount, typeName);
+    fwrite(value, 1, len, fp);
+    fputc('\n', fp);
+    printf("%d: %s, %.*s\n", tokenCount, typeName, (int)len, value);
+}
+
+// Count the newlines in [p, end)
+static uint32_t yy_countLines(const char* p, const char* end) {
+    uint32_t n = 0;
+    while ((p = (const char*)memchr(p, '\n', end - p)) != NULL) {
+        n++;
+        p++;
+    }
+    return n;
+}
+
+// Write the binary token file; fixed-spelling tokens point at their type's text in the pool
+static int yy_writeLexb(FILE* fp, const char* input, size_t size) {
+    yy_lexb_header header;
+    uint32_t offset = (uint32_t)size;
+    size_t i;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LEXB", 4);
+    header.version = 1;
+    header.typeCount = YY_TOKEN_NAME_COUNT;
+    header.tokenCount = (uint32_t)tokenCount;
+    header.poolSize = (uint32_t)size;
+    for (i = 0; i < YY_TOKEN_NAME_COUNT; i++) {
+        header.poolSize += (uint32_t)(strlen(yy_token_name[i]) + strlen(yy_token_text[i]));
+    }
+    strncpy(header.language, yy_language, sizeof(header.language) - 1);
+    fwrite(&header, sizeof(header), 1, fp);
+
+    for (i = 0; i < YY_TOKEN_NAME_COUNT; i++) {
+        yy_lexb_type type;
+        type.code = (uint32_t)yy_token_code[i];
+        type.nameOffset = offset;
+        type.nameLength = (uint32_t)strlen(yy_token_name[i]);
+        fwrite(&type, sizeof(type), 1, fp);
+        offset += type.nameLength + (uint32_t)strlen(yy_token_text[i]);
+    }
+
+    fwrite(yy_tokens, sizeof(yy_lexb_token), tokenCount, fp);
+    fwrite(input, 1, size, fp);
+    for (i = 0; i < YY_TOKEN_NAME_COUNT; i++) {
+        fputs(yy_token_name[i], fp);
+        fputs(yy_token_text[i], fp);
+    }
+    return ferror(fp) ? -1 : 0;
+}
+
+// Lexical analyzer over the whole input in memory
+int analyze(const char* input, size_t size, FILE* output_fp) {
+    const char* p = input;
+    uint32_t line = 1;
+    uint32_t textOffset[YY_TOKEN_NAME_COUNT + 1];
+    uint32_t offset = (uint32_t)size;
+    size_t i;
+    yy_end = input + size;
+
+    // Pool offsets of the fixed spellings in the binary file
+    for (i = 0; i < YY_TOKEN_NAME_COUNT; i++) {
+        offset += (uint32_t)strlen(yy_token_name[i]);
+        textOffset[i] = offset;
+        offset += (uint32_t)strlen(yy_token_text[i]);
+    }
+    
+    if (yy_textMode) {
+        printf("\n%s\n\n", yy_header);
+        fprintf(output_fp, "%s\n\n", yy_header);
+    }
+    
+    while (p < yy_end) {
+        char c = *p;
+        // Skip whitespace
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (c == '\n') line++;
+            p++;
+            continue;
+        }
+        
+        // Skip comments
+        if (yy_startsWith(p, yy_line_comment)) {
+            const char* end = (const char*)memchr(p, '\n', yy_end - p);
+            p = (end != NULL) ? end : yy_end;
+            continue;
+        }
+        if (yy_startsWith(p, yy_block_comment[0])) {
+            // Jump between occurrences of the first byte of the end marker
+            const char* begin = p;
+            p += strlen(yy_block_comment[0]);
+            while ((p = (const char*)memchr(p, yy_block_comment[1][0], yy_end - p)) != NULL &&
+                   !yy_startsWith(p, yy_block_comment[1])) {
+                p++;
+            }
+            p = (p != NULL) ? p + strlen(yy_block_comment[1]) : yy_end;
+            line += yy_countLines(begin, p);
+            continue;
+        }
+        
+        // Tokens recognized by the DFA, the accepting state tells which one
+        size_t len;
+        int tag = yy_match(p, &len);
+        if (tag >= 0) {
+            const char* text = yy_token_text[tag];
+            tokenCount++;
+            if (yy_textMode) {
+                if (text[0] != '\0') {
+                    outputToken(output_fp, yy_token_name[tag], text, strlen(text));
+                } else {
+                    outputToken(output_fp, yy_token_name[tag], p, len);
+                }
+            } else {
+                yy_lexb_token* token;
+                if ((size_t)tokenCount > yy_tokenCap) {
+                    yy_tokenCap = yy_tokenCap ? yy_tokenCap * 2 : 4096;
+                    token = (yy_lexb_token*)realloc(yy_tokens, yy_tokenCap * sizeof(yy_lexb_token));
+                    if (token == NULL) return -1;
+                    yy_tokens = token;
+                }
+                token = &yy_tokens[tokenCount - 1];
+                token->code = (uint32_t)yy_token_code[tag];
+                token->offset = text[0] != '\0' ? textOffset[tag] : (uint32_t)(p - input);
+                token->length = text[0] != '\0' ? (uint32_t)strlen(text) : (uint32_t)len;
+                token->line = line;
+            }
+            line += yy_countLines(p, p + len);
+            p += len;
+            continue;
+        }
+        
+        // Unknown characters are ignored
+        p++;
+    }
+    
+    if (!yy_textMode && yy_writeLexb(output_fp, input, size) != 0) return -1;
+    printf("\n%d tokens saved to output file\n", tokenCount);
+    return 0;
+}
+
+// Read the whole input into memory in large blocks, followed by a '\0' sentinel
+static char* yy_readFile(FILE* fp, size_t* size) {
+    size_t cap = 1 << 16, len = 0, n;
+    char* buf = (char*)malloc(cap + 1);
+    if (buf == NULL) return NULL;
+    while ((n = fread(buf + len, 1, cap - len, fp)) > 0) {
+        len += n;
+        if (len == cap) {
+            char* bigger = (char*)realloc(buf, cap * 2 + 1);
+            if (bigger == NULL) {
+                free(buf);
+                return NULL;
+            }
+            buf = bigger;
+            cap *= 2;
+        }
+    }
+    buf[len] = '\0';
+    *size = len;
+    return buf;
+}
+
+int main(int argc, char* argv[]) {
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-t") == 0) {
+        yy_textMode = 1;
+        arg++;
+    }
+    if (arg >= argc) {
+        printf("Usage: %s [-t] <input> [output]\n", argv[0]);
+        printf("Example: %s sample.tny                (binary tokens to sample.lexb)\n", argv[0]);
+        printf("         %s -t sample.tny result.lex  (readable text, for debugging)\n", argv[0]);
+        return 1;
+    }
+    
+    const char* inputFile = argv[arg];
+    const char* ext = yy_textMode ? ".lex" : ".lexb";
+    
+    // Output file: next argument, or the input file name with its extension replaced by .lexb / .lex
+    char outputFile[1024];
+    if (arg + 1 < argc) {
+        strcpy(outputFile, argv[arg + 1]);
+    } else {
+        strcpy(outputFile, inputFile);
+        char* dot = strrchr(outputFile, '.');
+        if (dot != NULL) {
+            strcpy(dot, ext);
+        } else {
+            strcat(outputFile, ext);
+        }
+    }
+    
+    printf("Input file:  %s\n", inputFile);
+    printf("Output file: %s\n", outputFile);
+    
+    FILE* input_fp = fopen(inputFile, "rb");
+    if (input_fp == NULL) {
+        printf("Error: Cannot open input file: %s\n", inputFile);
+        return 1;
+    }
+    size_t size;
+    char* input = yy_readFile(input_fp, &size);
+    fclose(input_fp);
+    if (input == NULL) {
+        printf("Error: Out of memory reading input file: %s\n", inputFile);
+        return 1;
+    }
+    
+    FILE* output_fp = fopen(outputFile, yy_textMode ? "w" : "wb");
+    if (output_fp == NULL) {
+        printf("Error: Cannot open output file: %s\n", outputFile);
+        free(input);
+        return 1;
+    }
+    
+    int status = analyze(input, size, output_fp);
+    if (status != 0) {
+        printf("Error: Cannot write output file: %s\n", outputFile);
+    }
+    
+    free(input);
+    free(yy_tokens);
+    fclose(output_fp);
+    
+    return status != 0;
+}
+)";
+
+    return lexCode;
+}
+
+/*============================分块并行词法分析==================================*/
+
+// 每块至少1MB，小文件分块的线程开销比扫描还大，直接串行分析
+const size_t parallelChunkBytes = 1 << 20;
+
+// 一块输入的推测分析结果
+struct ScanChunk
+{
+    size_t start = 0;           // 推测的单词边界，块起点之后第一个换行的下一个字节
+    size_t end = 0;             // 扫描停止的位置，是越过下一块起点后的第一个单词结尾
+    int endLine = 0;            // end 处的行号
+    vector<ScanToken> tokens;   // 行号从 start 处的0开始算
+};
+
+/*
+* @brief 推测分析一块输入
+* 每个单词都从DFA的初态开始识别，所以只要猜对一个单词边界，之后的结果就和串行分析相同。
+* 除第一块外从 from 之后的第一个换行处开始扫描（单词和大多数注释不跨行），扫到越过 limit 为止。
+* 是否第一块由 first 决定，不能看 from 是否为0：输入比块数还短时后面的块也从0开始
+*/
+void scanChunk(const DFAScanner& dfa, const LexLangProfile& profile, const char* src, size_t n,
+               size_t from, size_t limit, bool first, ScanChunk& chunk)
+{
+    size_t pos = from;
+    int line = 1;
+    if (!first) {
+        const void* newline = memchr(src + from, '\n', n - from);
+        pos = newline ? (const char*)newline - src + 1 : n;
+        line = 0;
+    }
+    chunk.start = pos;
+
+    ScanToken token;
+    while (pos < limit && scanToken(dfa, profile, src, n, pos, line, token)) {
+        chunk.tokens.push_back(token);
+    }
+    chunk.end = pos;
+    chunk.endLine = line;
+}
+
+/*
+* @brief 分块并行的词法分析，结果和 scanSource 完全相同
+* 输入分成 chunkCount 块，每块一个线程从推测的单词边界开始分析。然后按顺序拼接：
+* 前面的结果从自己的结尾继续串行分析，直到到达后一块的某个单词边界（同一位置开始分析，之后的单词必然相同），
+* 从这里接上后一块的单词并按行号差修正行号；到后一块结尾也没遇到共同的边界时推测失败，
+* 串行分析已经重新分析了这一块，直接丢弃它的结果。relexCount 为推测失败的块数
+*/
+vector<ScanToken> scanSourceParallel(const DFAScanner& dfa, const LexLangProfile& profile, const char* src, size_t n,
+                                     int chunkCount, int& relexCount)
+{
+    relexCount = 0;
+    // 每块至少一个字节，否则多出的块都是空的
+    chunkCount = (int)min<size_t>(chunkCount, n);
+    if (chunkCount < 2) {
+        return scanSource(dfa, profile, src, n);
+    }
+
+    vector<ScanChunk> chunks(chunkCount);
+    vector<thread> workers;
+    for (int k = 0; k < chunkCount; k++) {
+        size_t from = n / chunkCount * k;
+        size_t limit = (k == chunkCount - 1) ? n : n / chunkCount * (k + 1);
+        workers.emplace_back(scanChunk, cref(dfa), cref(profile), src, n, from, limit, k == 0, ref(chunks[k]));
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    vector<ScanToken> tokens = move(chunks[0].tokens);
+    size_t pos = chunks[0].end;
+    int line = chunks[0].endLine;
+    ScanToken token;
+    for (int k = 1; k < chunkCount; k++) {
+        ScanChunk& chunk = chunks[k];
+
+        // 找 pos 是否为这一块的单词边界：块的起点或某个单词的结尾
+        size_t first = 0;       // 从这一块的第几个单词接上
+        int chunkLine = 0;      // 这一块在 pos 处的行号
+        bool synced = false;
+        for (;;) {
+            if (pos == chunk.start) {
+                synced = true;
+                break;
+            }
+            if (pos > chunk.start) {
+                auto it = lower_bound(chunk.tokens.begin(), chunk.tokens.end(), pos,
+                                      [](const ScanToken& t, size_t p) { return t.offset + t.length < p; });
+                if (it != chunk.tokens.end() && it->offset + it->length == pos) {
+                    first = it - chunk.tokens.begin() + 1;
+                    chunkLine = it->line + count(src + it->offset, src + pos, '\n');
+                    synced = true;
+                    break;
+                }
+            }
+            if (pos >= chunk.end || !scanToken(dfa, profile, src, n, pos, line, token)) {
+                break;
+            }
+            tokens.push_back(token);
+        }
+
+        if (!synced) {
+            relexCount++;
+            continue;
+        }
+        int lineDelta = line - chunkLine;
+        for (size_t i = first; i < chunk.tokens.size(); i++) {
+            tokens.push_back(chunk.tokens[i]);
+            tokens.back().line += lineDelta;
+        }
+        pos = chunk.end;
+        line = chunk.endLine + lineDelta;
+        vector<ScanToken>().swap(chunk.tokens);
+    }
+
+    // 最后一块推测失败时串行分析到输入结尾
+    while (scanToken(dfa, profile, src, n, pos, line, token)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// 按文件大小和CPU核数决定分几块，小文件返回1
+int parallelChunkCount(size_t n)
+{
+    int cores = max(1, (int)thread::hardware_concurrency());
+    return (int)min<size_t>(cores, max<size_t>(1, n / parallelChunkBytes));
+}
+
+/*============================增量词法分析==================================*/
+
+/*
+* @brief 文本格式的词法分析结果，和生成的词法分析程序用 -t 写出的 .lex 文件相同，
+* 格式为 "序号: 类别, 单词"，用于显示和调试
+*/
+string LexerCompilation::lexText(const vector<ScanToken>& tokens, const char* src, const LexLangProfile& profile) const
+{
+    string result = lexHeader(profile.name) + "\n\n";
+    int tokenCount = 0;
+    for (const ScanToken& token : tokens) {
+        const AcceptTag& tag = acceptTags[token.tag];
+        result += to_string(++tokenCount) + ": " + tag.name + ", ";
+        if (tag.text.empty()) {
+            result.append(src + token.offset, token.length);
+        } else {
+            result += tag.text;
+        }
+        result += "\n";
+    }
+    return result;
+}
+
+/*============================二进制单词文件==================================*/
+
+/*
+* @brief 二进制单词文件 .lexb 的格式，整数都是小端序的 uint32_t
+* 依次为文件头、单词类别表、单词表和字符串池。字符串池开头是整个源程序，
+* 之后是各类别的名称和固定写法，单词的 offset/length 直接指向池中的源程序，
+* 读取时把文件映射到内存后按结构体访问即可，不需要再解析文本。
+* 生成的词法分析程序写出同样的格式，SLR1分析器生成的语法分析程序读取它
+*/
+struct LexbHeader
+{
+    char magic[4];          // "LEXB"
+    uint32_t version;       // 格式版本，目前为1
+    uint32_t typeCount;     // 单词类别数，每个规则标记一个
+    uint32_t tokenCount;    // 单词数
+    uint32_t poolSize;      // 字符串池字节数
+    char language[12];      // 语言名，如 "TINY"、"Mini-C"，不足补0
+};
+
+// 单词类别：编码和名称，名称在字符串池中
+struct LexbType
+{
+    uint32_t code;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+// 单词：编码、单词在字符串池中的位置和所在行
+struct LexbToken
+{
+    uint32_t code;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t line;
+};
+
+const char lexbMagic[4] = {'L', 'E', 'X', 'B'};
+const uint32_t lexbVersion = 1;
+
+// 把结构体的字节追加到输出
+template <class T>
+void appendBytes(string& out, const T& value)
+{
+    out.append((const char*)&value, sizeof(T));
+}
+
+/*
+* @brief 二进制格式的词法分析结果，写入 .lexb 文件
+* 固定写法的单词（如忽略大小写的关键字）指向池中该类别的写法，其余指向源程序
+*/
+string LexerCompilation::lexBinary(const vector<ScanToken>& tokens, const char* src, size_t n, const LexLangProfile& profile) const
+{
+    // 字符串池：源程序，然后是各类别的名称和固定写法
+    string pool(src, n);
+    vector<LexbType> types;
+    vector<uint32_t> textOffset;
+    for (const AcceptTag& tag : acceptTags) {
+        types.push_back({(uint32_t)tag.code, (uint32_t)pool.size(), (uint32_t)tag.name.size()});
+        pool += tag.name;
+        textOffset.push_back(pool.size());
+        pool += tag.text;
+    }
+
+    LexbHeader header = {};
+    memcpy(header.magic, lexbMagic, sizeof(lexbMagic));
+    header.version = lexbVersion;
+    header.typeCount = types.size();
+    header.tokenCount = tokens.size();
+    header.poolSize = pool.size();
+    strncpy(header.language, profile.name.c_str(), sizeof(header.language) - 1);
+
+    string out;
+    out.reserve(sizeof(LexbHeader) + types.size() * sizeof(LexbType) + tokens.size() * sizeof(LexbToken) + pool.size());
+    appendBytes(out, header);
+    for (const LexbType& type : types) {
+        appendBytes(out, type);
+    }
+    for (const ScanToken& token : tokens) {
+        const AcceptTag& tag = acceptTags[token.tag];
+        LexbToken record = {(uint32_t)tag.code, (uint32_t)token.offset, (uint32_t)token.length, (uint32_t)token.line};
+        if (!tag.text.empty()) {
+            record.offset = textOffset[token.tag];
+            record.length = tag.text.size();
+        }
+        appendBytes(out, record);
+    }
+    out += pool;
+    return out;
+}
+
+// 数据是否为 .lexb 文件
+bool isLexbData(const char* data, size_t size)
+{
+    return size >= sizeof(lexbMagic) && memcmp(data, lexbMagic, sizeof(lexbMagic)) == 0;
+}
+
+/*
+* @brief 把 .lexb 文件的内容转成文本格式，用于查看
+* data 为映射到内存的文件，格式不对时返回错误信息
+*/
+string lexbToText(const char* data, size_t size, string& text)
+{
+    if (size < sizeof(LexbHeader) || !isLexbData(data, size)) {
+        return "不是二进制单词文件！";
+    }
+    LexbHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != lexbVersion) {
+        return "二进制单词文件版本为 " + to_string(header.version) + "，不支持！";
+    }
+    size_t typesAt = sizeof(LexbHeader);
+    size_t tokensAt = typesAt + (size_t)header.typeCount * sizeof(LexbType);
+    size_t poolAt = tokensAt + (size_t)header.tokenCount * sizeof(LexbToken);
+    if (poolAt + header.poolSize > size) {
+        return "二进制单词文件不完整！";
+    }
+    const char* pool = data + poolAt;
+
+    map<uint32_t, string> typeName;
+    for (uint32_t i = 0; i < header.typeCount; i++) {
+        LexbType type;
+        memcpy(&type, data + typesAt + i * sizeof(LexbType), sizeof(type));
+        if ((size_t)type.nameOffset + type.nameLength > header.poolSize) {
+            return "二进制单词文件中的类别名称越界！";
+        }
+        typeName.insert({type.code, string(pool + type.nameOffset, type.nameLength)});
+    }
+
+    string language(header.language, strnlen(header.language, sizeof(header.language)));
+    text = lexHeader(language) + "\n\n";
+    for (uint32_t i = 0; i < header.tokenCount; i++) {
+        LexbToken token;
+        memcpy(&token, data + tokensAt + i * sizeof(LexbToken), sizeof(token));
+        if ((size_t)token.offset + token.length > header.poolSize) {
+            return "二进制单词文件中第 " + to_string(i + 1) + " 个单词越界！";
+        }
+        text += to_string(i + 1) + ": " + typeName[token.code] + ", ";
+        text.append(pool + token.offset, token.length);
+        text += "\n";
+    }
+    return "";
+}
+
+/*
+* @brief 初始化函数
+* 用于清空这次编译的全部表
+*/
+void LexerCompilation::init() {
+    // 各表清空
+    keyWords.clear();
+    opMap.clear();
+    regexAst.clear();
+    tagAstRoot.clear();
+    regexLine->clear();
+    commentSymbol->clear();
+    nfaArena.clear();
+    nfaCharSet.clear();
+    dfaCharSet.clear();
+    statusTable.clear();
+    insertionOrder.clear();
+    startNFAstatus.clear();
+    endNFAstatus.clear();
+    dfaStateSets.reset(0);
+    dfaRuleStates.clear();
+    closureRowOf.clear();
+    closureBits.clear();
+    closureWords = 0;
+    dfaEndStatusSet.clear();
+    dfaNotEndStatusSet.clear();
+    dfaMinTable.clear();
+    dfaMinMap.clear();
+    dfaClassTable.clear();
+    fill(byteClassMap, byteClassMap + 256, 0);
+    byteClassCount = 0;
+    dfaTable.clear();
+    varDefMap.clear();
+    regexToGenerate.clear();
+    acceptTags.clear();
+    tagEndNFAstatus.clear();
+    varNodeMap.clear();
+    symbolTable.clear();
+    symbolIndex.clear();
+    symbolAtoms.clear();
+    nfaCharSet.insert(EPSILON); // 放入epsilon
+}
+
+/*============================自动机缓存==================================*/
+
+/*
+* 规则没有变（或只改了注释、空行）时，"开始分析"直接读入上次构造的NFA、DFA、最小化DFA和输入符号表，
+* 不再重新构造。缓存文件名是规格化后的规则、忽略大小写选项、NFA构造方法和DFA构造方式的哈希值，
+* 这些内容本身也写在缓存文件中，读入时逐字比较，哈希值碰撞时不会读入别的规则的自动机。
+* 这里只负责缓存文件的内容，文件放在哪里、怎样读写由界面程序决定，文件整个映射到内存后顺序读出各个表
+*/
+
+// 缓存文件格式改变时加1，旧的缓存文件不再使用
+const int automatonCacheVersion = 3;
+
+// 缓存文件开头的标记
+const char automatonCacheMagic[4] = {'R', '2', 'L', 'A'};
+
+/*
+* @brief 规格化后的规则加上选项
+* 规格化和 handleAllRegex 一样去掉每行两端的空白、空行和 # 注释行，只改这些时仍然命中缓存
+*/
+string automatonCacheSpec(const string& allRegex, bool lowerCase, NFAConstruction construction, bool perRule)
+{
+    string normalized;
+    for (const string& line : splitString(allRegex, '\n', true)) {
+        string trimmedLine = trimString(line);
+        if (trimmedLine.empty() || trimmedLine[0] == '#') continue;
+        normalized += trimmedLine;
+        normalized += '\n';
+    }
+    normalized += lowerCase ? "i" : "c";
+    normalized += (construction == NFA_GLUSHKOV) ? "g" : "t";
+    normalized += perRule ? "r" : "s";
+    normalized += to_string(automatonCacheVersion);
+    return normalized;
+}
+
+// 缓存的键：automatonCacheSpec 的64位FNV-1a哈希，只用作文件名，是否命中由缓存中的 spec 决定
+uint64_t automatonCacheKey(const string& spec)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (unsigned char c : spec) {
+        h ^= c;
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/*
+* @brief 缓存文件的写入
+* 整数按本机字节序原样写入，容器先写元素个数再逐个写元素，int 和 uint64_t 数组整块写入。
+* 方法都叫 io，和 AutomatonReader 对应，写入和读出共用 automatonTables 中的一份顺序
+*/
+class AutomatonWriter
+{
+public:
+    string out;
+
+    void io(int v)
+    {
+        out.append((const char*)&v, sizeof(v));
+    }
+
+    void io(uint64_t v)
+    {
+        out.append((const char*)&v, sizeof(v));
+    }
+
+    void io(unsigned char v)
+    {
+        out += (char)v;
+    }
+
+    void io(bool v)
+    {
+        out += (char)v;
+    }
+
+    void io(const string& s)
+    {
+        io((int)s.size());
+        out += s;
+    }
+
+    void io(const vector<int>& v)
+    {
+        io((int)v.size());
+        out.append((const char*)v.data(), v.size() * sizeof(int));
+    }
+
+    void io(const vector<uint64_t>& v)
+    {
+        io((int)v.size());
+        out.append((const char*)v.data(), v.size() * sizeof(uint64_t));
+    }
+
+    template <class A, class B>
+    void io(const pair<A, B>& p)
+    {
+        io(p.first);
+        io(p.second);
+    }
+
+    template <class T>
+    void io(const vector<T>& v)
+    {
+        io((int)v.size());
+        for (const T& x : v) io(x);
+    }
+
+    template <class T>
+    void io(const set<T>& v)
+    {
+        io((int)v.size());
+        for (const T& x : v) io(x);
+    }
+
+    template <class K, class V>
+    void io(const map<K, V>& m)
+    {
+        io((int)m.size());
+        for (const auto& kv : m) io(kv);
+    }
+
+    // 结构体数组只写元素个数，成员由调用者逐个写
+    template <class T>
+    void items(const vector<T>& v)
+    {
+        io((int)v.size());
+    }
+};
+
+/*
+* @brief 缓存文件的读出，和 AutomatonWriter 对应
+* 每次读都检查剩余长度，文件损坏或被截断时 good() 为false，不会读出界
+*/
+class AutomatonReader
+{
+public:
+    AutomatonReader(const char* data, size_t size) : p(data), end(data + size), ok(true) {}
+
+    bool good() const
+    {
+        return ok;
+    }
+
+    bool atEnd() const
+    {
+        return p == end;
+    }
+
+    void io(int& v)
+    {
+        raw(&v, sizeof(v));
+    }
+
+    void io(uint64_t& v)
+    {
+        raw(&v, sizeof(v));
+    }
+
+    void io(unsigned char& v)
+    {
+        raw(&v, sizeof(v));
+    }
+
+    void io(bool& v)
+    {
+        unsigned char c = 0;
+        io(c);
+        v = c != 0;
+    }
+
+    void io(string& s)
+    {
+        int n = count(1);
+        s.assign(p, n);
+        p += n;
+    }
+
+    void io(vector<int>& v)
+    {
+        v.resize(count(sizeof(int)));
+        raw(v.data(), v.size() * sizeof(int));
+    }
+
+    void io(vector<uint64_t>& v)
+    {
+        v.resize(count(sizeof(uint64_t)));
+        raw(v.data(), v.size() * sizeof(uint64_t));
+    }
+
+    template <class A, class B>
+    void io(pair<A, B>& p)
+    {
+        io(p.first);
+        io(p.second);
+    }
+
+    template <class T>
+    void io(vector<T>& v)
+    {
+        v.resize(count(1));
+        for (T& x : v) io(x);
+    }
+
+    template <class T>
+    void io(set<T>& v)
+    {
+        int n = count(1);
+        v.clear();
+        for (int i = 0; i < n && ok; i++) {
+            T x;
+            io(x);
+            v.insert(v.end(), x);
+        }
+    }
+
+    template <class K, class V>
+    void io(map<K, V>& m)
+    {
+        int n = count(1);
+        m.clear();
+        for (int i = 0; i < n && ok; i++) {
+            pair<K, V> kv;
+            io(kv);
+            m.insert(m.end(), kv);
+        }
+    }
+
+    template <class T>
+    void items(vector<T>& v)
+    {
+        v.assign(count(1), T());
+    }
+
+private:
+    // 读出元素个数，每个元素至少占 elementSize 字节，超出剩余长度时失败并返回0
+    int count(size_t elementSize)
+    {
+        int n = 0;
+        io(n);
+        if (!ok || n < 0 || (size_t)n > (size_t)(end - p) / elementSize) {
+            ok = false;
+            return 0;
+        }
+        return n;
+    }
+
+    void raw(void* dst, size_t n)
+    {
+        if (!ok || (size_t)(end - p) < n) {
+            ok = false;
+            return;
+        }
+        if (n > 0) memcpy(dst, p, n);
+        p += n;
+    }
+
+    const char* p;
+    const char* end;
+    bool ok;
+};
+
+/*
+* @brief 按固定顺序写入或读出分析得到的全部表
+* Archive 为 AutomatonWriter 时写入，为 AutomatonReader 时读出。
+* 只解析规则时用到的表（关键字、运算符、语法树等）不写入
+*/
+template <class Archive>
+void LexerCompilation::automatonTables(Archive& ar)
+{
+    // 输入符号表（字母表）和字节原子
+    ar.items(symbolTable);
+    for (InputSymbol& symbol : symbolTable) {
+        ar.io(symbol.name);
+        ar.io(symbol.ranges);
+    }
+    ar.io(symbolAtoms);
+
+    // 单词标记
+    ar.items(acceptTags);
+    for (AcceptTag& tag : acceptTags) {
+        ar.io(tag.name);
+        ar.io(tag.code);
+        ar.io(tag.text);
+    }
+    ar.io(tagEndNFAstatus);
+
+    // 规则：变量定义和需要生成DFA的规则，查看规则和按规则构造时使用
+    ar.io(varDefMap);
+    ar.items(regexToGenerate);
+    for (TokenRule& rule : regexToGenerate) {
+        ar.io(rule.name);
+        ar.io(rule.regex);
+        ar.io(rule.code);
+        ar.io(rule.multi);
+        ar.io(rule.firstTag);
+        ar.io(rule.tagCount);
+    }
+
+    // NFA：状态池、状态转换表和ε闭包
+    ar.io(nfaArena.stateCount);
+    ar.io(nfaArena.edgeStart);
+    ar.io(nfaArena.edgeSym);
+    ar.io(nfaArena.edgeNext);
+    ar.io(startNFAstatus);
+    ar.io(endNFAstatus);
+    ar.items(statusTable);
+    for (statusTableNode& node : statusTable) {
+        ar.io(node.flag);
+        ar.io(node.id);
+        ar.io(node.m);
+    }
+    ar.io(insertionOrder);
+    ar.io(nfaCharSet);
+    ar.io(closureWords);
+    ar.io(closureRowOf);
+    ar.io(closureBits);
+
+    // DFA：状态集合驻留表和状态转换表
+    ar.io(dfaStateSets.words);
+    ar.io(dfaStateSets.pool);
+    ar.io(dfaStateSets.hashes);
+    ar.io(dfaStateSets.buckets);
+    ar.io(dfaRuleStates);
+    ar.items(dfaTable);
+    for (dfaNode& node : dfaTable) {
+        ar.io(node.flag);
+        ar.io(node.tag);
+        ar.io(node.transitions);
+    }
+    ar.io(dfaCharSet);
+    ar.io(dfaEndStatusSet);
+    ar.io(dfaNotEndStatusSet);
+
+    // 最小化DFA
+    ar.items(dfaMinTable);
+    for (dfaMinNode& node : dfaMinTable) {
+        ar.io(node.flag);
+        ar.io(node.id);
+        ar.io(node.tag);
+        ar.io(node.transitions);
+    }
+    ar.io(dfaMinMap);
+
+    // 字节等价类，状态多时按256列重新计算比读入慢得多
+    ar.io(byteClassCount);
+    for (int& c : byteClassMap) {
+        ar.io(c);
+    }
+    ar.io(dfaClassTable);
+}
+
+// 把当前分析得到的表（包括字节等价类）写成缓存文件的内容
+string LexerCompilation::saveAutomaton(const string& spec)
+{
+    AutomatonWriter writer;
+    writer.out.append(automatonCacheMagic, sizeof(automatonCacheMagic));
+    writer.io(automatonCacheVersion);
+    writer.io(spec);
+    automatonTables(writer);
+    return writer.out;
+}
+
+// 下标 i 在 [lo, hi) 内
+static bool inRange(long long i, long long lo, size_t hi)
+{
+    return i >= lo && i < (long long)hi;
+}
+
+// 集合中的每个元素都在 [lo, hi) 内
+template <class C>
+static bool allInRange(const C& items, long long lo, size_t hi)
+{
+    for (int i : items) {
+        if (!inRange(i, lo, hi)) return false;
+    }
+    return true;
+}
+
+// 每行 words 个字的位图中，没有编号不小于 bitCount 的位
+static bool bitsWithin(const vector<uint64_t>& bits, int words, int bitCount)
+{
+    int lastWord = bitCount / 64;
+    uint64_t lastMask = (bitCount % 64 == 0) ? 0 : (~0ULL >> (64 - bitCount % 64));
+    for (size_t row = 0; row < bits.size(); row += words) {
+        for (int w = lastWord; w < words; w++) {
+            if (bits[row + w] & ~(w == lastWord ? lastMask : 0)) return false;
+        }
+    }
+    return true;
+}
+
+/*
+* @brief 检查从缓存读入的表
+* 缓存文件可能被截断、改动或来自有问题的旧版本，格式读对了不代表内容可用。
+* 这里检查各表之间引用的下标（符号、NFA状态、单词标记、DFA状态、等价类）都在范围内，
+* 通过后词法分析、生成程序和结果展示都不会越界访问
+*/
+string LexerCompilation::checkAutomaton() const
+{
+    size_t symbols = symbolTable.size();
+    for (const InputSymbol& symbol : symbolTable) {
+        for (const auto& r : symbol.ranges) {
+            if (r.first > r.second) return "符号的字节区间无效";
+        }
+    }
+    // 原子必须是 dfaCharSet 中的符号，LazyDFA 按原子在 dfaCharSet 中的位置建表
+    if (symbolAtoms.size() > symbols || !allInRange(dfaCharSet, 0, symbols)) return "字节原子表无效";
+    for (const vector<int>& atoms : symbolAtoms) {
+        for (int atom : atoms) {
+            if (!dfaCharSet.count(atom)) return "字节原子表无效";
+        }
+    }
+
+    // NFA
+    size_t tags = acceptTags.size();
+    int states = nfaArena.stateCount;
+    const vector<int>& edgeStart = nfaArena.edgeStart;
+    if (states < 0 || edgeStart.size() != (size_t)states + 1 || edgeStart[0] != 0 ||
+        (size_t)edgeStart.back() != nfaArena.edgeSym.size() || nfaArena.edgeSym.size() != nfaArena.edgeNext.size()) {
+        return "NFA边表无效";
+    }
+    for (int s = 0; s < states; s++) {
+        if (edgeStart[s] > edgeStart[s + 1]) return "NFA边表无效";
+    }
+    if (!allInRange(nfaArena.edgeSym, EPSILON, symbols) || !allInRange(nfaArena.edgeNext, 0, states)) {
+        return "NFA边表无效";
+    }
+    if (tagEndNFAstatus.size() > tags || startNFAstatus.empty() || !allInRange(startNFAstatus, 0, states) ||
+        !allInRange(endNFAstatus, 0, states)) {
+        return "NFA初态或终态无效";
+    }
+    for (const vector<int>& ends : tagEndNFAstatus) {
+        if (!allInRange(ends, 0, states)) return "NFA终态无效";
+    }
+    for (const TokenRule& rule : regexToGenerate) {
+        if (rule.firstTag < 0 || rule.tagCount < 0 || (size_t)rule.firstTag + rule.tagCount > tags) return "规则的单词标记无效";
+    }
+    for (const statusTableNode& node : statusTable) {
+        for (const auto& entry : node.m) {
+            if (!inRange(entry.first, EPSILON, symbols) || !allInRange(entry.second, 0, statusTable.size())) {
+                return "NFA状态转换表无效";
+            }
+        }
+    }
+    if (!allInRange(insertionOrder, 0, statusTable.size()) || !allInRange(nfaCharSet, EPSILON, symbols)) {
+        return "NFA状态转换表无效";
+    }
+    // 两种构造都计算了ε闭包，每个NFA状态一行；位图中不能有超出状态数的位，LazyDFA 按位取NFA状态的出边
+    if (closureWords <= 0 || (size_t)closureWords * 64 < (size_t)states || closureRowOf.size() != (size_t)states ||
+        closureBits.size() % closureWords != 0 || !allInRange(closureRowOf, 0, closureBits.size() / closureWords) ||
+        !bitsWithin(closureBits, closureWords, states)) {
+        return "ε闭包表无效";
+    }
+
+    // DFA，状态编号从1开始
+    size_t dfaStates = dfaTable.size();
+    // 开放定址表：大小为2的幂，至少空一半，存的都是集合下标
+    const vector<int>& buckets = dfaStateSets.buckets;
+    if (dfaStateSets.words != closureWords || buckets.empty() || (buckets.size() & (buckets.size() - 1)) != 0 ||
+        dfaStateSets.hashes.size() * 2 > buckets.size() || !allInRange(buckets, -1, dfaStateSets.hashes.size())) {
+        return "DFA状态集合表无效";
+    }
+    if (dfaRuleStates.empty()) {
+        if (dfaStateSets.hashes.size() != dfaStates || dfaStateSets.pool.size() != (size_t)closureWords * dfaStates ||
+            !bitsWithin(dfaStateSets.pool, closureWords, states)) {
+            return "DFA状态集合表无效";
+        }
+    } else {
+        if (dfaRuleStates.size() != dfaStates) return "DFA状态集合表无效";
+        for (const vector<int>& ruleStates : dfaRuleStates) {
+            for (size_t i = 0; i < ruleStates.size(); i += 2) {
+                if (!inRange(ruleStates[i], 0, tags) || i + 1 == ruleStates.size()) return "DFA状态集合表无效";
+            }
+        }
+    }
+    for (const dfaNode& node : dfaTable) {
+        if (!inRange(node.tag, -1, tags)) return "DFA状态的单词标记无效";
+        for (const auto& entry : node.transitions) {
+            if (!inRange(entry.first, 0, symbols) || (entry.second != -1 && !inRange(entry.second, 1, dfaStates + 1))) {
+                return "DFA状态转换表无效";
+            }
+        }
+    }
+    if (!allInRange(dfaEndStatusSet, 1, dfaStates + 1) ||
+        !allInRange(dfaNotEndStatusSet, 1, dfaStates + 1)) {
+        return "DFA状态转换表无效";
+    }
+
+    // 最小化DFA：状态的 id 就是下标，必须有初态
+    size_t minStates = dfaMinTable.size();
+    if (minStates == 0) return "最小化DFA为空";
+    bool hasStart = false;
+    for (size_t i = 0; i < minStates; i++) {
+        const dfaMinNode& node = dfaMinTable[i];
+        if (node.id != (int)i || !inRange(node.tag, -1, tags)) return "最小化DFA状态无效";
+        hasStart = hasStart || node.flag.find("-") != string::npos;
+        for (const auto& entry : node.transitions) {
+            if (!inRange(entry.first, 0, symbols) || (entry.second != -1 && !inRange(entry.second, 0, minStates))) {
+                return "最小化DFA状态转换表无效";
+            }
+        }
+    }
+    if (!hasStart) return "最小化DFA没有初态";
+    if (!dfaMinMap.empty() && (dfaMinMap.size() != dfaStates + 1 || !allInRange(dfaMinMap, -1, minStates))) {
+        return "最小化状态映射无效";
+    }
+
+    // 字节等价类
+    if (byteClassCount <= 0 || byteClassCount > 256 || dfaClassTable.size() != minStates ||
+        !allInRange(byteClassMap, 0, byteClassCount)) {
+        return "字节等价类无效";
+    }
+    for (const vector<int>& row : dfaClassTable) {
+        if (row.size() != (size_t)byteClassCount || !allInRange(row, -1, minStates)) return "等价类转移表无效";
+    }
+    return "";
+}
+
+/*
+* @brief 从缓存文件的内容读入全部表，返回错误信息，空串表示成功
+* 失败时各表可能只读了一部分，调用者要重新 init()
+*/
+string LexerCompilation::loadAutomaton(const char* data, size_t size, const string& spec)
+{
+    if (size < sizeof(automatonCacheMagic) ||
+        memcmp(data, automatonCacheMagic, sizeof(automatonCacheMagic)) != 0) {
+        return "不是自动机缓存文件";
+    }
+
+    AutomatonReader reader(data + sizeof(automatonCacheMagic), size - sizeof(automatonCacheMagic));
+    int version = 0;
+    reader.io(version);
+    if (!reader.good() || version != automatonCacheVersion) {
+        return "缓存文件版本不符";
+    }
+    string storedSpec;
+    reader.io(storedSpec);
+    if (!reader.good() || storedSpec != spec) {
+        return "缓存文件的规则或选项不符";
+    }
+    automatonTables(reader);
+    if (!reader.good() || !reader.atEnd()) {
+        return "缓存文件已损坏";
+    }
+    string error = checkAutomaton();
+    if (!error.empty()) {
+        return "缓存文件已损坏：" + error;
+    }
+
+    // 符号驻留表由符号表重建
+    for (size_t i = 0; i < symbolTable.size(); i++) {
+        symbolIndex[{symbolTable[i].name, symbolTable[i].ranges}] = i;
+    }
+    return "";
+}
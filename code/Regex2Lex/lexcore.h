@@ -0,0 +1,1350 @@
+﻿/****************************************************
+ * @FileName: lexcore.h
+ * @Brief: 词法分析器生成的核心算法
+ * @Module Function: 规则解析、正则表达式转NFA、NFA转DFA、DFA最小化、生成词法分析程序和程序内的词法分析，
+ *                   只依赖C++标准库，图形界面（widget.cpp）和命令行工具（cli/main.cpp）共用
+ *
+ ****************************************************/
+#ifndef LEXCORE_H
+#define LEXCORE_H
+
+#include <map>
+#include <vector>
+#include <set>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define REGEX2LEX_SSE2 1
+#endif
+
+using namespace std;
+
+/*============================调试输出==================================*/
+
+/*
+* @brief 调试信息的输出位置，默认为空，不输出
+* 图形界面把它设为 qDebug，命令行工具加 -v 时输出到 stderr
+*/
+extern void (*coreDebugSink)(const string& message);
+
+/*
+* @brief 一条调试信息，用法和 qDebug() 相同：CoreDebug() << "状态数 " << n;
+* 析构时整条交给 coreDebugSink，没有设置输出位置时不做格式化
+*/
+class CoreDebug
+{
+public:
+    CoreDebug() : active(coreDebugSink != nullptr)
+    {
+        out << boolalpha;
+    }
+
+    ~CoreDebug()
+    {
+        if (active) coreDebugSink(out.str());
+    }
+
+    template <class T>
+    CoreDebug& operator<<(const T& value)
+    {
+        if (active) out << value;
+        return *this;
+    }
+
+private:
+    bool active;
+    ostringstream out;
+};
+
+// 字节区间集合：区间从小到大排列，互不重叠也不相邻，如 [A-Za-z] 为 {(A,Z), (a,z)}
+typedef vector<pair<unsigned char, unsigned char>> ByteRanges;
+
+/*
+* @brief 输入符号，即NFA边和DFA转移上的标记
+* 每个符号是一个字节区间集合，用 symbolTable 中的下标表示：单个字节、字符类、变量、字节原子都是符号，
+* [0-9] 这样的字符类只是一条边，不再每个字符一条边。
+* 自动机直接工作在UTF-8字节上，符号里存的就是源程序中的字节，
+* 不再把转义的运算符编码成控制字符、把变量编码成128以上的字符，源程序中的任何字节都不会和内部编码冲突
+*/
+struct InputSymbol
+{
+    string name;            // 显示形式，如 a、+、letter、[a-ce-z]、\xE4
+    ByteRanges ranges;      // 包含的字节
+};
+
+// 空边，不是符号表中的符号
+const int EPSILON = -1;
+
+/*
+* @brief 单词标记，DFA终态据此知道识别出的是哪个单词
+* 每条规则一个标记，多单词规则（编码后带S）的每个选择分支各一个标记，编码依次加1。
+* 标记按规则顺序编号，一个状态同时包含多个标记的终态时取编号小的，即前面的规则优先
+*/
+struct AcceptTag
+{
+    string name;    // 单词类别，即规则名称
+    int code;       // 单词编码
+    string text;    // 多单词规则中单词的固定写法，输出时代替读到的字符串；其他为空
+};
+
+/*
+* @brief 一条需要生成DFA的规则（以_开头的定义）
+* 编码和多单词标志都记在规则自己身上，不按名称查表，名称相同的两条规则互不影响
+*/
+struct TokenRule
+{
+    string name;        // 单词类别，去掉下划线和编码后的名称
+    string regex;       // 正则表达式
+    int code;           // 单词编码，多单词规则为第一个单词的编码
+    bool multi;         // 编码后带S，每个选择分支是一个单词
+    int firstTag;       // 第一个单词标记（acceptTags下标），解析出语法树后填写
+    int tagCount;       // 单词标记个数
+};
+// set转string
+string set2string(set<int> s);
+
+/*============================输入符号==================================*/
+
+// 单个字节的显示形式，不可见字符和非ASCII字节写成 \xHH
+string byteName(unsigned char b);
+
+// 字节集合的显示形式，如 [a-ce-z]，两个字节的区间写成 [ab]
+string rangesDisplay(const ByteRanges& ranges);
+
+// 码点的UTF-8编码
+string encodeUtf8(int cp);
+
+/*============================正则表达式语法树==================================*/
+
+/*
+* @brief 正则表达式语法树结点类型
+*/
+enum RegexKind
+{
+    REGEX_CHAR,     // 单个字符
+    REGEX_CLASS,    // 字符类 [...]
+    REGEX_VAR,      // 变量引用，如 letter
+    REGEX_CONCAT,   // 连接
+    REGEX_ALT,      // 选择 |
+    REGEX_STAR,     // 闭包 *
+    REGEX_PLUS,     // 正闭包 +
+    REGEX_OPTIONAL  // 可选 ?
+};
+
+/*
+* @brief 结构体，正则表达式语法树结点
+* 结点统一存放在 regexAst 中，用下标互相引用
+*/
+struct RegexNode
+{
+    RegexKind kind;
+    int sym;            // 叶结点（字符、字符类、变量）：输入符号编号，其他为-1
+    int left;           // 左子结点（一元运算只用left），-1表示无
+    int right;          // 右子结点，-1表示无
+};
+
+/*============================正则表达式转NFA==================================*/
+
+/*
+* @brief NFA状态池
+* 状态用连续的编号表示，不再为每个结点单独new。
+* 构建时边追加到 buildFrom/buildSym/buildNext 三个数组中，边上是输入符号编号或EPSILON，
+* 构建完成后 finalize() 按起点整理成CSR形式：
+* 状态 s 的出边为 edgeSym/edgeNext 的 [edgeStart[s], edgeStart[s+1]) 区间。
+* clear() 只清空内容不释放内存，重新分析时复用
+*/
+struct NFAArena
+{
+    int stateCount = 0;
+
+    // 构建阶段的边表
+    vector<int> buildFrom;
+    vector<int> buildSym;
+    vector<int> buildNext;
+
+    // CSR形式的边表
+    vector<int> edgeStart;  // 大小为 stateCount+1
+    vector<int> edgeSym;
+    vector<int> edgeNext;
+
+    int newState()
+    {
+        return stateCount++;
+    }
+
+    void addEdge(int from, int sym, int next)
+    {
+        buildFrom.push_back(from);
+        buildSym.push_back(sym);
+        buildNext.push_back(next);
+    }
+
+    // 按起点计数排序，同一状态的边保持添加顺序
+    void finalize()
+    {
+        int edgeCount = buildFrom.size();
+        edgeStart.assign(stateCount + 1, 0);
+        for (int i = 0; i < edgeCount; i++) {
+            edgeStart[buildFrom[i] + 1]++;
+        }
+        for (int s = 0; s < stateCount; s++) {
+            edgeStart[s + 1] += edgeStart[s];
+        }
+        edgeSym.resize(edgeCount);
+        edgeNext.resize(edgeCount);
+        vector<int> fill(edgeStart.begin(), edgeStart.end() - 1);
+        for (int i = 0; i < edgeCount; i++) {
+            int pos = fill[buildFrom[i]]++;
+            edgeSym[pos] = buildSym[i];
+            edgeNext[pos] = buildNext[i];
+        }
+        buildFrom.clear();
+        buildSym.clear();
+        buildNext.clear();
+    }
+
+    void clear()
+    {
+        stateCount = 0;
+        buildFrom.clear();
+        buildSym.clear();
+        buildNext.clear();
+        edgeStart.clear();
+        edgeSym.clear();
+        edgeNext.clear();
+    }
+};
+
+/*
+* @brief 结构体，NFA图
+* 只记录初态和终态在状态池中的编号
+*/
+struct NFA
+{
+    int start;
+    int end;
+    NFA()
+    {
+        start = -1;
+        end = -1;
+    }
+    NFA(int s, int e)
+    {
+        start = s;
+        end = e;
+    }
+};
+
+/*
+* @brief 结构体，状态转换表单个结点
+*/
+struct statusTableNode
+{
+    string flag;  // 标记初态还是终态
+    int id; // 唯一id值
+    map<int, set<int>> m;  // 对应符号能到达的状态
+    statusTableNode()
+    {
+        flag = ""; // 默认为空
+    }
+};
+
+// NFA构造方法
+enum NFAConstruction
+{
+    NFA_THOMPSON,   // Thompson构造，带ε边
+    NFA_GLUSHKOV    // Glushkov构造，无ε边，每个符号出现一个状态
+};
+/*============================NFA转DFA==================================*/
+
+// dfa节点
+struct dfaNode
+{
+    string flag; // 是否包含终态（+）或初态（-）
+    int tag; // 接受的单词标记（acceptTags下标），-1表示非终态
+    map<int, int> transitions; // 符号（字节原子）到下一状态编号的映射（编号从1开始）
+    dfaNode() {
+        flag = "";
+        tag = -1;
+    }
+};
+
+// 位图中是否含有NFA状态s
+inline bool bitsHas(const uint64_t* bits, int s)
+{
+    return (bits[s / 64] >> (s % 64)) & 1;
+}
+
+/*
+* @brief 状态集合的位图表示
+* 第 i 位为1表示包含NFA状态 i，每个 uint64_t 存64个状态
+*/
+typedef vector<uint64_t> StateBits;
+
+// 64位整数最低位1的位置
+inline int lowestBit(uint64_t w)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, w);
+    return (int)idx;
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+/*
+* @brief DFA状态集合驻留表
+* 每个不同的NFA状态集合只保存一份位图，所有位图连续存放在 pool 中，
+* 第 i 个集合就是编号为 i+1 的DFA状态；查找时先算64位哈希，
+* 再在开放定址表中线性探测，哈希相等时才逐字比较位图
+*/
+struct StateSetTable
+{
+    int words = 0;              // 每个集合占的 uint64_t 个数
+    vector<uint64_t> pool;      // 第 i 个集合位于 [i*words, (i+1)*words)
+    vector<uint64_t> hashes;    // 第 i 个集合的哈希值
+    vector<int> buckets;        // 开放定址表，存集合下标，-1为空
+
+    void reset(int w)
+    {
+        words = w;
+        pool.clear();
+        hashes.clear();
+        buckets.assign(64, -1);
+    }
+
+    int size() const
+    {
+        return (int)hashes.size();
+    }
+
+    const uint64_t* get(int i) const
+    {
+        return &pool[(size_t)i * words];
+    }
+
+    static uint64_t hashBits(const uint64_t* bits, int n)
+    {
+        uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)n;
+        for (int w = 0; w < n; w++) {
+            h ^= bits[w];
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+        }
+        return h;
+    }
+
+    // 表中元素超过一半时扩容，用已存的哈希值重新放置
+    void grow()
+    {
+        buckets.assign(buckets.size() * 2, -1);
+        size_t mask = buckets.size() - 1;
+        for (int i = 0; i < size(); i++) {
+            size_t pos = hashes[i] & mask;
+            while (buckets[pos] != -1) pos = (pos + 1) & mask;
+            buckets[pos] = i;
+        }
+    }
+
+    // 查找集合，不存在则加入；返回集合下标，isNew 表示是否是新加入的
+    int intern(const uint64_t* bits, bool& isNew)
+    {
+        return intern(bits, hashBits(bits, words), isNew);
+    }
+
+    // 同上，哈希值 h 已经算好
+    int intern(const uint64_t* bits, uint64_t h, bool& isNew)
+    {
+        size_t mask = buckets.size() - 1;
+        size_t pos = h & mask;
+        while (buckets[pos] != -1) {
+            int i = buckets[pos];
+            if (hashes[i] == h && equal(bits, bits + words, get(i))) {
+                isNew = false;
+                return i;
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        int id = size();
+        pool.insert(pool.end(), bits, bits + words);
+        hashes.push_back(h);
+        buckets[pos] = id;
+        if ((size_t)size() * 2 > buckets.size()) {
+            grow();
+        }
+        isNew = true;
+        return id;
+    }
+};
+
+// 完整子集构造允许的最大DFA状态数
+const int eagerDFAStateLimit = 1 << 18;
+
+/*============================DFA最小化==================================*/
+// dfa最小化节点
+struct dfaMinNode
+{
+    string flag; // 是否包含终态（+）或初态（-）
+    int id;
+    int tag; // 接受的单词标记，-1表示非终态
+    map<int, int> transitions; // 符号（字节原子）到下一状态的映射
+    dfaMinNode() {
+        flag = "";
+        tag = -1;
+    }
+};
+
+/*============================自环状态加速==================================*/
+
+// 自环字节最多包含几个区间，超过时不加速（SSE2每个区间要3条指令）
+const int selfLoopMaxRanges = 4;
+
+// 找出最小化DFA中可以加速的自环状态
+vector<ByteRanges> selfLoopRanges(const vector<vector<int>>& rows);
+
+/*
+* @brief 一个自环状态上跳过整段字节的扫描器
+* 有SSE2时每次检查16个字节：x - lo 按无符号比较不超过 hi - lo 即在区间 [lo, hi] 内，
+* 没有SSE2或剩余不足16个字节时逐字节查表
+*/
+class SelfLoop
+{
+public:
+    explicit SelfLoop(const ByteRanges& ranges = ByteRanges()) : count(ranges.size())
+    {
+        fill(member, member + 256, false);
+        for (int i = 0; i < count; i++) {
+            const auto& r = ranges[i];
+            fill(member + r.first, member + r.second + 1, true);
+#ifdef REGEX2LEX_SSE2
+            lo[i] = _mm_set1_epi8((char)r.first);
+            width[i] = _mm_set1_epi8((char)(r.second - r.first));
+#endif
+        }
+    }
+
+    // 是否为可加速的自环状态
+    bool active() const
+    {
+        return count > 0;
+    }
+
+    // 从 pos 开始跳过自环上的字节，返回第一个不在自环上的位置
+    size_t skip(const char* src, size_t pos, size_t n) const
+    {
+#ifdef REGEX2LEX_SSE2
+        while (n - pos >= 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(src + pos));
+            __m128i in = _mm_setzero_si128();
+            for (int i = 0; i < count; i++) {
+                __m128i d = _mm_sub_epi8(x, lo[i]);
+                in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_min_epu8(d, width[i]), d));
+            }
+            unsigned out = ~(unsigned)_mm_movemask_epi8(in) & 0xFFFF;
+            if (out != 0) {
+                return pos + lowestBit(out);
+            }
+            pos += 16;
+        }
+#endif
+        while (pos < n && member[(unsigned char)src[pos]]) pos++;
+        return pos;
+    }
+
+private:
+    int count;          // 区间个数，0表示不加速
+    bool member[256];
+#ifdef REGEX2LEX_SSE2
+    __m128i lo[selfLoopMaxRanges];
+    __m128i width[selfLoopMaxRanges];
+#endif
+};
+
+/*
+* @brief 语言相关的补充词法信息
+* 所有单词（包括关键字、运算符、界符）都在规则中定义，由最小化DFA识别，
+* 这里只剩注释符号和结果文件头
+*/
+struct LexLangProfile
+{
+    string name;                // 语言名称，写入结果文件头
+    string lineComment;         // 行注释开始符号
+    string blockComment[2];     // 块注释开始、结束符号
+};
+
+extern const LexLangProfile tinyProfile;
+
+extern const LexLangProfile miniCProfile;
+
+// 词法分析结果文件头，Mini-C的文件头带语言名，SLR1分析器据此识别语言
+string lexHeader(const string& language);
+
+// 生成的词法分析程序的形式
+enum LexerBackend
+{
+    LEXER_TABLE,    // 表驱动，查等价类和转移表
+    LEXER_DIRECT    // 直接编码，每个状态一段代码
+};
+
+/*============================按规则构造的DFA==================================*/
+
+/*
+* @brief 一条规则单独构造的最小化DFA
+* 不引用编译中的符号表和单词标记：转移表按这条规则自己的字节等价类分列，
+* 接受标记是规则内单词的序号（多单词规则的第几个分支），所以规则没有改动时下一次编译可以直接使用
+*/
+struct RuleDFA
+{
+    int classOf[256];       // 字节 -> 等价类
+    int classCount = 0;     // 等价类个数
+    int start = 0;          // 初态
+    vector<int> next;       // next[状态 * classCount + 等价类]，-1表示无转移
+    vector<int> tag;        // 状态接受规则内的第几个单词，-1表示非终态
+};
+
+/*
+* @brief 各条规则的DFA缓存，在多次编译之间保留
+* 键是规则的语法树和用到的字节集合，只改了一条规则时其他规则的键不变，
+* 所以只有这一条规则需要重新构造。可以在多个线程中同时使用
+*/
+class RuleDFACache
+{
+public:
+    shared_ptr<const RuleDFA> find(const string& key)
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = dfas.find(key);
+        return it == dfas.end() ? nullptr : it->second;
+    }
+
+    void insert(const string& key, shared_ptr<const RuleDFA> dfa)
+    {
+        lock_guard<mutex> guard(lock);
+        dfas[key] = dfa;
+    }
+
+    // 只留下 keys 中的DFA，删掉改动前的规则
+    void retain(const set<string>& keys)
+    {
+        lock_guard<mutex> guard(lock);
+        for (auto it = dfas.begin(); it != dfas.end();) {
+            it = keys.count(it->first) ? next(it) : dfas.erase(it);
+        }
+    }
+
+    size_t size()
+    {
+        lock_guard<mutex> guard(lock);
+        return dfas.size();
+    }
+
+private:
+    mutex lock;
+    map<string, shared_ptr<const RuleDFA>> dfas;
+};
+
+/*============================一次编译的全部状态==================================*/
+
+struct GlushkovInfo;
+struct ScanToken;
+
+/*
+* @brief 一次编译：从规则到最小化DFA的全部表和各个阶段
+* 各阶段读写的表都是这里的成员，各阶段是成员函数，不同的对象互不共享状态，
+* 所以多份规则可以在不同线程中同时编译，图形界面也可以在后台分析时继续显示上一次的结果。
+* 一个对象同一时间只能由一个线程修改，编译完成后的 const 成员函数可以在多个线程中同时调用
+*/
+class LexerCompilation
+{
+public:
+    LexerCompilation()
+    {
+        init();
+    }
+
+    // 清空全部表，每次分析前调用
+    void init();
+
+    // 对正则表达式进行处理，返回错误信息，空串表示成功
+    string handleAllRegex(const string& allRegex, bool isLowerCase);
+
+    // 正则表达式转NFA入口
+    NFA regex2NFA();
+
+    // 把NFA边上的符号划分成互不相交的字节原子
+    void splitSymbolAtoms();
+
+    // 子集构造法
+    bool NFA2DFA(NFA& nfa, int maxStates = -1);
+
+    // 按规则构造DFA：每条规则在自己的线程中构造最小化DFA，再用乘积构造合并，代替 NFA2DFA；
+    // cache 不为空时没有改动的规则直接使用缓存中的DFA
+    bool rules2DFA(RuleDFACache* cache, int maxStates = -1);
+
+    // Hopcroft算法最小化DFA
+    void DFAminimize();
+
+    // 计算字节等价类
+    void DFAbyteClasses();
+
+    // 由最小化DFA生成词法分析程序（C源代码）
+    string generateLexer(int langIndex, LexerBackend backend) const;
+
+    // 符号的显示形式，空边显示为 #
+    string symbolName(int sym) const;
+
+    // 测试输出NFA状态转换表程序（debug使用）
+    void printStatusTable() const;
+
+    // 判断状态集合接受哪个单词，同时包含多个标记的终态时取编号小的（规则在前的优先）
+    int setAcceptTag(const uint64_t* bits) const;
+
+    // 单词标记的显示形式，如 " ID"、" KEYWORD(if)"，非终态为空
+    string tagLabel(int tag) const;
+
+    // 把NFA状态s的ε闭包并入位图
+    void orClosure(StateBits& bits, int s) const
+    {
+        const uint64_t* row = &closureBits[(size_t)closureRowOf[s] * closureWords];
+        for (int w = 0; w < closureWords; w++) {
+            bits[w] |= row[w];
+        }
+    }
+
+    // 编号为 number 的DFA状态包含的NFA状态，用于结果展示
+    set<int> dfaNFAStates(int number) const;
+
+    // DFA状态的显示形式：子集构造为NFA状态集合，如 {1,2,5}；按规则构造为各规则DFA的状态，如 {ID:3,NUM:0}
+    string dfaStateLabel(int number) const;
+
+    // DFA debug输出函数
+    void printDfaTable(const vector<dfaNode>& dfaTable) const;
+
+    // 把最小化DFA展开成按字节的转移行
+    vector<vector<int>> dfaMinByteRows() const;
+
+    // 最小化DFA的初态，标志中带 - 的状态
+    int dfaMinStartState() const;
+
+    // 文本格式的词法分析结果，和生成的词法分析程序用 -t 写出的 .lex 文件相同
+    string lexText(const vector<ScanToken>& tokens, const char* src, const LexLangProfile& profile) const;
+
+    // 二进制格式的词法分析结果，写入 .lexb 文件
+    string lexBinary(const vector<ScanToken>& tokens, const char* src, size_t n, const LexLangProfile& profile) const;
+
+    // 把当前分析得到的表（包括字节等价类）写成缓存文件的内容，spec 为 automatonCacheSpec 的结果
+    string saveAutomaton(const string& spec);
+
+    // 从缓存文件的内容读入全部表，缓存中的 spec 和给出的不同时不读入；返回错误信息，空串表示成功；失败时要重新 init()
+    string loadAutomaton(const char* data, size_t size, const string& spec);
+
+    // 符号表，下标即符号编号
+    vector<InputSymbol> symbolTable;
+    // (显示形式, 字节集合) -> 符号编号，相同的符号只保存一份
+    map<pair<string, ByteRanges>, int> symbolIndex;
+
+    // 变量定义表 (如 letter=[A-Za-z])
+    map<string, string> varDefMap;
+
+    // 需要生成DFA的规则列表 (以_开头的)，按定义顺序
+    vector<TokenRule> regexToGenerate;
+
+    vector<AcceptTag> acceptTags;
+    // 每个标记对应的NFA终态编号（Thompson构造每个标记一个终态，Glushkov构造可能有多个）
+    vector<vector<int>> tagEndNFAstatus;
+
+    // 是否忽略大小写（默认不忽略）
+    bool isLowerCase = false;
+
+    // 输入符号统计（符号编号）
+    set<int> nfaCharSet;
+    set<int> dfaCharSet;
+
+    NFAArena nfaArena;
+
+    // 状态转换表，下标即状态编号
+    vector<statusTableNode> statusTable;
+    // statusTable输出顺序记录（初态在前，终态在后）
+    vector<int> insertionOrder;
+    set<int> startNFAstatus;
+    set<int> endNFAstatus;
+
+    NFAConstruction nfaConstruction = NFA_THOMPSON;
+
+    // 子集构造的线程数，0表示按CPU核数，1表示只用串行算法
+    int subsetThreads = 0;
+
+    // NFA边上的符号 -> 它覆盖的字节原子（下标为符号编号）
+    vector<vector<int>> symbolAtoms;
+
+    // dfa最终结果，第 i 个节点的编号为 i+1
+    vector<dfaNode> dfaTable;
+
+    //下面用于DFA最小化
+    // dfa终态集合
+    set<int> dfaEndStatusSet;
+    // dfa非终态集合
+    set<int> dfaNotEndStatusSet;
+
+    // ε闭包缓存：每个ε边强连通分量一行位图
+    int closureWords = 0;           // 每行的 uint64_t 个数
+    vector<int> closureRowOf;       // NFA状态 -> 所在强连通分量（闭包行号）
+    vector<uint64_t> closureBits;   // 各强连通分量的ε闭包，按行连续存放
+
+    // DFA状态对应的NFA状态集合
+    StateSetTable dfaStateSets;
+    // 按规则构造时DFA状态对应的各规则DFA状态，依次为 (规则的第一个单词标记, 状态) 对，子集构造时为空
+    vector<vector<int>> dfaRuleStates;
+    // 上一次 rules2DFA 重新构造和从缓存取得的规则DFA个数
+    int ruleDFAsBuilt = 0;
+    int ruleDFAsReused = 0;
+
+    vector<dfaMinNode> dfaMinTable;
+
+    // DFA状态编号 -> 最小化后的状态下标（下标0不用）
+    vector<int> dfaMinMap;
+
+    // 字节 -> 等价类编号
+    int byteClassMap[256];
+    // 等价类个数
+    int byteClassCount = 0;
+    // 最小化DFA按等价类的转移表，dfaClassTable[状态][等价类]，-1表示无转移
+    vector<vector<int>> dfaClassTable;
+
+private:
+    friend struct RegexParser;
+
+    void getKeyWords(const string& regex);
+    string getOpName(const string& regex1, const string& regex2);
+    string getCommentSymbol(string& regex);
+
+    int internSymbol(const string& name, const ByteRanges& ranges);
+    int byteSymbol(unsigned char b);
+    int rangesSymbol(const ByteRanges& ranges);
+
+    int newRegexNode(RegexKind kind, int sym = -1, int left = -1, int right = -1);
+    int byteNode(unsigned char b);
+    int codePointNode(int cp);
+    void collectAltBranches(int idx, vector<int>& branches) const;
+    bool astLiteralText(int idx, string& text) const;
+    string defineVariable(const string& name, const string& regex);
+    void ruleAstKey(int idx, map<int, int>& seen, string& key) const;
+    int copyRuleAst(int idx, LexerCompilation& sub, map<int, int>& copied) const;
+    shared_ptr<RuleDFA> buildRuleDFA(size_t firstTag, size_t lastTag, int maxStates) const;
+
+    NFA CreateBasicNFA(int sym);
+    NFA CreateConcatenationNFA(NFA nfa1, NFA nfa2);
+    NFA CreateUnionNFA(NFA nfa1, NFA nfa2);
+    NFA CreateZeroOrMoreNFA(NFA nfa1);
+    NFA CreateOptionalNFA(NFA nfa1);
+    NFA CreateOneOrMoreNFA(NFA nfa1);
+    void createNFAStatusTable(NFA& nfa);
+    NFA ast2NFA(int idx);
+    GlushkovInfo glushkovBuild(int idx);
+    void glushkovAddEdges(int from, int pos);
+    NFA glushkovNFA();
+    NFA thompsonNFA();
+
+    string setHasStartOrEnd(const uint64_t* bits) const;
+    void buildEpsilonClosures();
+    void subsetMoves(const uint64_t* bits, vector<StateBits>& moveBits, vector<bool>& moved) const;
+    bool parallelSubsets(int cur, int maxStates, int threadCount);
+    string generateDirectMatch(int startState) const;
+
+    // 缓存文件的读写共用一份表的列表
+    template <class Archive>
+    void automatonTables(Archive& ar);
+
+    // 检查读入的表互相引用的下标都在范围内，返回错误信息
+    string checkAutomaton() const;
+
+    // 变量名 -> 引用变量时使用的语法树结点：字符集合的变量是一个叶结点，其他变量是整个定义的语法树
+    map<string, int> varNodeMap;
+
+    // 正则表达式行合集
+    string regexLine[5];
+    // 关键词合集
+    set<string> keyWords;
+    // 操作符号map
+    map<string,string> opMap;
+    // 注释符号集合，0为开始符号，1为结束符号
+    string commentSymbol[2];
+
+    // 语法树结点池
+    vector<RegexNode> regexAst;
+    // 每个单词标记（按acceptTags顺序）的语法树根
+    vector<int> tagAstRoot;
+
+    // Glushkov构造中每个位置（NFA状态）对应的语法树叶结点
+    vector<int> glushkovPosNode;
+    // 每个位置的follow集合
+    vector<vector<int>> glushkovFollow;
+
+    int startStaus;
+};
+
+/*============================按需构造的DFA==================================*/
+
+/*
+* @brief 按需构造的DFA（懒惰DFA）
+* 不预先做完整的子集构造，扫描输入时才由NFA算出用到的DFA状态和转移，
+* 状态集合存放在驻留表中，转移表每个状态一行、按字节原子分列，-2表示还没算过。
+* 缓存的状态占用超过预算时整个清空，从当前状态重新开始构造（和RE2的做法相同），
+* 所以规则再大内存也有上限，而实际输入只会用到其中一小部分状态
+*/
+class LazyDFA
+{
+public:
+    LazyDFA(const LexerCompilation& compilation, size_t cacheBytes) : lc(&compilation)
+    {
+        const vector<InputSymbol>& symbolTable = lc->symbolTable;
+        const set<int>& dfaCharSet = lc->dfaCharSet;
+        words = lc->closureWords;
+        atomCount = dfaCharSet.size();
+
+        // 字节 -> 原子下标，忽略大小写时大写字母按小写字母处理
+        int atomIndex = 0;
+        fill(atomOfByte, atomOfByte + 256, -1);
+        symbolCovers.assign(symbolTable.size(), vector<char>(atomCount, 0));
+        for (int atom : dfaCharSet) {
+            for (const auto& r : symbolTable[atom].ranges) {
+                fill(atomOfByte + r.first, atomOfByte + r.second + 1, atomIndex);
+            }
+            atomIndex++;
+        }
+        if (lc->isLowerCase) {
+            for (int c = 'A'; c <= 'Z'; c++) {
+                if (atomOfByte[c] == -1) atomOfByte[c] = atomOfByte[tolower(c)];
+            }
+        }
+        // NFA边上的符号覆盖哪些原子
+        for (size_t sym = 0; sym < lc->symbolAtoms.size(); sym++) {
+            for (int atom : lc->symbolAtoms[sym]) {
+                symbolCovers[sym][distance(dfaCharSet.begin(), dfaCharSet.find(atom))] = 1;
+            }
+        }
+
+        // 每个状态大约占用：位图 + 一行转移 + 哈希值、开放定址表和标记
+        size_t stateBytes = words * sizeof(uint64_t) + atomCount * sizeof(int) + 24;
+        maxStates = max<size_t>(cacheBytes / stateBytes, 2);
+
+        startBits.assign(words, 0);
+        lc->orClosure(startBits, startNFAstate());
+        moveBits.assign(words, 0);
+        flushCount = 0;
+        builtCount = 0;
+        reset();
+    }
+
+    // 初态总是0号
+    int start() const
+    {
+        return 0;
+    }
+
+    // 状态接受的单词标记，-1表示非终态
+    int tag(int state) const
+    {
+        return tags[state];
+    }
+
+    /*
+    * @brief 读入一个字节后的状态，-1表示死状态
+    * 缓存清空后原来的状态编号全部失效，调用者只能继续使用返回的新编号
+    */
+    int next(int state, unsigned char byte)
+    {
+        int atom = atomOfByte[byte];
+        if (atom < 0) return -1;
+        size_t cell = (size_t)state * atomCount + atom;
+        if (rows[cell] != -2) return rows[cell];
+
+        // 扫描状态中各NFA状态覆盖该原子的出边，目标的ε闭包或到一起
+        fill(moveBits.begin(), moveBits.end(), 0);
+        bool moved = false;
+        const uint64_t* bits = sets.get(state);
+        const NFAArena& nfaArena = lc->nfaArena;
+        for (int w = 0; w < words; w++) {
+            uint64_t word = bits[w];
+            while (word) {
+                int s = w * 64 + lowestBit(word);
+                word &= word - 1;
+                for (int e = nfaArena.edgeStart[s]; e < nfaArena.edgeStart[s + 1]; e++) {
+                    int sym = nfaArena.edgeSym[e];
+                    if (sym == EPSILON || !symbolCovers[sym][atom]) continue;
+                    lc->orClosure(moveBits, nfaArena.edgeNext[e]);
+                    moved = true;
+                }
+            }
+        }
+        if (!moved) {
+            rows[cell] = -1;
+            return -1;
+        }
+
+        bool isNew;
+        int target = addState(moveBits.data(), isNew);
+        if (isNew && (size_t)sets.size() > maxStates) {
+            // 超出预算：清空缓存，只保留初态和新状态，当前这条转移不再记录
+            reset();
+            flushCount++;
+            return addState(moveBits.data(), isNew);
+        }
+        rows[cell] = target;
+        return target;
+    }
+
+    int cachedStates() const
+    {
+        return sets.size();
+    }
+
+    // 状态按需构造，没有事先分析自环，不跳过
+    size_t skip(int, const char*, size_t pos, size_t) const
+    {
+        return pos;
+    }
+
+    size_t maxStates;   // 缓存最多容纳的状态数
+    int flushCount;     // 缓存清空次数
+    int builtCount;     // 累计构造的状态数（含清空前的）
+
+private:
+    // NFA初态：startNFAstatus 中唯一的状态
+    int startNFAstate() const
+    {
+        return *lc->startNFAstatus.begin();
+    }
+
+    void reset()
+    {
+        sets.reset(words);
+        rows.clear();
+        tags.clear();
+        bool isNew;
+        addState(startBits.data(), isNew);
+    }
+
+    int addState(const uint64_t* bits, bool& isNew)
+    {
+        int id = sets.intern(bits, isNew);
+        if (isNew) {
+            rows.resize(rows.size() + atomCount, -2);
+            tags.push_back(lc->setAcceptTag(bits));
+            builtCount++;
+        }
+        return id;
+    }
+
+    const LexerCompilation* lc;     // 规则编译的结果，要比 LazyDFA 活得久
+    int words;
+    int atomCount;
+    int atomOfByte[256];
+    vector<vector<char>> symbolCovers;  // symbolCovers[符号][原子]
+    StateSetTable sets;
+    vector<int> rows;
+    vector<int> tags;
+    StateBits startBits;
+    StateBits moveBits;
+};
+
+// 按需构造DFA的缓存预算
+const size_t lazyCacheBytes = 8 << 20;
+
+/*============================DFA扫描器==================================*/
+
+// 扫描得到的单词：接受标记和它在输入中的位置，不复制单词内容
+struct ScanToken
+{
+    int tag;        // acceptTags 中的下标
+    size_t offset;  // 起始位置
+    size_t length;  // 长度
+    int line;       // 所在行号，从1开始
+    size_t reach;   // 识别这个单词（连同前面的空白、注释）时读到的最远位置之后，超过输入长度表示读到了输入结尾
+};
+
+/*
+* @brief 最小化DFA的扫描器
+* 构造时复制 byteClassMap、dfaClassTable 和各状态的接受标记，之后不再依赖 LexerCompilation，
+* 不生成C代码也能在别的程序中使用。接口和 LazyDFA 相同，由 scanToken 驱动
+*/
+class DFAScanner
+{
+public:
+    DFAScanner() : classCount(0), startState(0)
+    {
+    }
+
+    explicit DFAScanner(const LexerCompilation& lc)
+    {
+        classCount = lc.byteClassCount;
+        copy(lc.byteClassMap, lc.byteClassMap + 256, classOf);
+        startState = lc.dfaMinStartState();
+        table.reserve(lc.dfaClassTable.size() * classCount);
+        for (const vector<int>& row : lc.dfaClassTable) {
+            table.insert(table.end(), row.begin(), row.end());
+        }
+        for (const dfaMinNode& node : lc.dfaMinTable) {
+            tags.push_back(node.tag);
+        }
+        for (const ByteRanges& ranges : selfLoopRanges(lc.dfaMinByteRows())) {
+            loops.emplace_back(ranges);
+        }
+    }
+
+    int start() const
+    {
+        return startState;
+    }
+
+    // 状态接受的单词标记，-1表示非终态
+    int tag(int state) const
+    {
+        return tags[state];
+    }
+
+    // 读入一个字节后的状态，-1表示死状态
+    int next(int state, unsigned char byte) const
+    {
+        return table[state * classCount + classOf[byte]];
+    }
+
+    // 在自环状态中跳过整段转回自己的字节，返回第一个不在自环上的位置
+    size_t skip(int state, const char* src, size_t pos, size_t n) const
+    {
+        const SelfLoop& loop = loops[state];
+        return loop.active() ? loop.skip(src, pos, n) : pos;
+    }
+
+private:
+    int classCount;
+    int startState;
+    int classOf[256];
+    vector<int> table;  // table[状态 * classCount + 等价类]
+    vector<int> tags;
+    vector<SelfLoop> loops;
+};
+
+// 输入从 pos 开始是否为 str
+inline bool inputStartsWith(const char* src, size_t n, size_t pos, const string& str)
+{
+    return !str.empty() && n - pos >= str.size() && memcmp(src + pos, str.data(), str.size()) == 0;
+}
+
+/*
+* @brief 从 pos 开始识别下一个单词，返回false表示输入已结束
+* 和生成的词法分析程序行为一致：跳过空白和注释，按最长匹配识别单词，不能识别的字符忽略。
+* line 为 pos 所在的行号，随 pos 一起前进。DFA 可以是 DFAScanner 或 LazyDFA
+*/
+template <class DFA>
+bool scanToken(DFA& dfa, const LexLangProfile& profile, const char* src, size_t n, size_t& pos, int& line,
+               ScanToken& token)
+{
+    const string& lineComment = profile.lineComment;
+    const string& blockStart = profile.blockComment[0];
+    const string& blockEnd = profile.blockComment[1];
+    size_t reach = pos;
+
+    while (pos < n) {
+        char c = src[pos];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (c == '\n') line++;
+            pos++;
+            continue;
+        }
+
+        // 注释
+        if (inputStartsWith(src, n, pos, lineComment)) {
+            const void* end = memchr(src + pos, '\n', n - pos);
+            pos = end ? (const char*)end - src : n;
+            continue;
+        }
+        if (inputStartsWith(src, n, pos, blockStart)) {
+            size_t begin = pos;
+            pos += blockStart.size();
+            while (pos < n && !inputStartsWith(src, n, pos, blockEnd)) {
+                // 在结束符号的第一个字节之间跳
+                const void* next = memchr(src + pos + 1, blockEnd.empty() ? 0 : blockEnd[0], n - pos - 1);
+                pos = next ? (const char*)next - src : n;
+            }
+            pos = min(n, pos + blockEnd.size());
+            line += count(src + begin, src + pos, '\n');
+            continue;
+        }
+
+        // 最长匹配
+        int state = dfa.start();
+        int lastTag = -1;
+        size_t lastLen = 0;
+        size_t i = pos;
+        while (i < n) {
+            state = dfa.next(state, (unsigned char)src[i]);
+            if (state < 0) break;
+            i = dfa.skip(state, src, i + 1, n);
+            if (dfa.tag(state) >= 0) {
+                lastTag = dfa.tag(state);
+                lastLen = i - pos;
+            }
+        }
+        reach = max(reach, i + 1);  // 读了 src[i] 才停下，i == n 时读到了输入结尾
+        if (lastTag < 0) {
+            pos++;  // 不能识别的字符忽略
+            continue;
+        }
+
+        // 单词开始处还比较过注释开始符号
+        reach = max(reach, pos + max(lineComment.size(), blockStart.size()));
+        token = {lastTag, pos, lastLen, line, reach};
+        line += count(src + pos, src + pos + lastLen, '\n');
+        pos += lastLen;
+        return true;
+    }
+    return false;
+}
+
+// 对整个源程序做词法分析，得到全部单词
+template <class DFA>
+vector<ScanToken> scanSource(DFA& dfa, const LexLangProfile& profile, const char* src, size_t n)
+{
+    vector<ScanToken> tokens;
+    size_t pos = 0;
+    int line = 1;
+    ScanToken token;
+    while (scanToken(dfa, profile, src, n, pos, line, token)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+/*============================分块并行词法分析==================================*/
+
+// 分块并行的词法分析，结果和 scanSource 完全相同
+vector<ScanToken> scanSourceParallel(const DFAScanner& dfa, const LexLangProfile& profile, const char* src, size_t n,
+                                     int chunkCount, int& relexCount);
+
+// 按文件大小和CPU核数决定分几块，小文件返回1
+int parallelChunkCount(size_t n);
+
+/*============================增量词法分析==================================*/
+
+/*
+* @brief 编辑器中的增量词法分析
+* 每个单词都从DFA的初态开始识别，单词的结尾就是检查点：从这里重新分析只需要位置和行号。
+* 修改一段文本后，从第一个读到修改处的单词前的检查点开始重新分析，
+* 直到新的单词结尾和修改处之后某个旧单词的结尾重合，之后的单词不变，只是位置和行号整体平移。
+* 单词放在间隙缓冲区中，间隙停在上次修改处：替换单词只需改动间隙两边，
+* 间隙之后的单词的平移记在 offsetShift、lineShift 上，间隙移动时才结算，
+* 所以在大文件中连续修改时每次只需要重新分析附近的几个单词
+*/
+class IncrementalLexer
+{
+public:
+    // 用 lc 的最小化DFA分析整个文本
+    void reset(const LexerCompilation& lc, const string& source, const LexLangProfile& languageProfile)
+    {
+        dfa = DFAScanner(lc);
+        profile = &languageProfile;
+        text = source;
+        buffer = scanSource(dfa, *profile, text.data(), text.size());
+        gapStart = gapEnd = buffer.size();
+        offsetShift = 0;
+        lineShift = 0;
+        maxLookahead = 0;
+        for (const ScanToken& token : buffer) {
+            maxLookahead = max(maxLookahead, token.reach - (token.offset + token.length));
+        }
+    }
+
+    /*
+    * @brief 把文本 [start, start + removed) 替换为 inserted，重新分析受影响的单词
+    * 返回重新分析得到的单词数
+    */
+    size_t edit(size_t start, size_t removed, const string& inserted)
+    {
+        // 第一个读到 start 处的单词：结尾在 start 之后的单词都读到了，
+        // 再往前找向后多读的单词，比最大的多读距离还远的不用找
+        size_t first = findEnd(0, tokenCount(), start + 1);
+        for (size_t i = first; i > 0; i--) {
+            ScanToken token = at(i - 1);
+            if (token.offset + token.length + maxLookahead <= start) break;
+            if (token.reach > start) first = i - 1;
+        }
+
+        // 从前一个单词的结尾（检查点）开始重新分析
+        size_t pos = 0;
+        int line = 1;
+        if (first > 0) {
+            ScanToken token = at(first - 1);
+            pos = token.offset + token.length;
+            line = token.line + count(text.begin() + token.offset, text.begin() + pos, '\n');
+        }
+
+        text.replace(start, removed, inserted);
+        ptrdiff_t delta = (ptrdiff_t)inserted.size() - (ptrdiff_t)removed;
+        size_t editEnd = start + inserted.size();
+
+        // 重新分析到和修改处之后的旧单词结尾重合为止，last 为重合的旧单词之后的下标
+        vector<ScanToken> fresh;
+        size_t last = tokenCount();
+        int lineDelta = 0;
+        ScanToken token;
+        while (scanToken(dfa, *profile, text.data(), text.size(), pos, line, token)) {
+            maxLookahead = max(maxLookahead, token.reach - pos);
+            fresh.push_back(token);
+            if (pos < editEnd) continue;
+
+            // 旧单词要整个在修改处之后，才能从新文本中数出它原来的换行
+            size_t oldEnd = pos - delta;
+            size_t m = findEnd(first, tokenCount(), oldEnd);
+            if (m == tokenCount()) continue;
+            ScanToken old = at(m);
+            if (old.offset + old.length == oldEnd && old.offset >= start + removed) {
+                int oldLine = old.line + count(text.begin() + pos - old.length, text.begin() + pos, '\n');
+                lineDelta = line - oldLine;
+                last = m + 1;
+                break;
+            }
+        }
+
+        // 旧单词 [first, last) 换成新分析的单词，之后的单词平移 delta 个字节、lineDelta 行
+        moveGap(first);
+        gapEnd += last - first;
+        offsetShift += delta;
+        lineShift += lineDelta;
+        if (gapEnd - gapStart < fresh.size()) {
+            growGap(fresh.size());
+        }
+        copy(fresh.begin(), fresh.end(), buffer.begin() + gapStart);
+        gapStart += fresh.size();
+        return fresh.size();
+    }
+
+    size_t tokenCount() const
+    {
+        return buffer.size() - (gapEnd - gapStart);
+    }
+
+    // 第 i 个单词，间隙之后的单词加上还没有结算的平移
+    ScanToken at(size_t i) const
+    {
+        if (i < gapStart) {
+            return buffer[i];
+        }
+        ScanToken token = buffer[i + (gapEnd - gapStart)];
+        shift(token, offsetShift, lineShift);
+        return token;
+    }
+
+    const string& source() const
+    {
+        return text;
+    }
+
+    // 第 line 行（从1开始）开始的位置，从这一行之前最近的单词往后数换行
+    size_t lineOffset(int line) const
+    {
+        size_t pos = 0;
+        int current = 1;
+        size_t lo = 0, hi = tokenCount();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (at(mid).line < line) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo > 0) {
+            ScanToken token = at(lo - 1);
+            pos = token.offset;
+            current = token.line;
+        }
+        while (current < line && pos < text.size()) {
+            const void* newline = memchr(text.data() + pos, '\n', text.size() - pos);
+            if (!newline) return text.size();
+            pos = (const char*)newline - text.data() + 1;
+            current++;
+        }
+        return pos;
+    }
+
+private:
+    static void shift(ScanToken& token, ptrdiff_t offsetDelta, int lineDelta)
+    {
+        token.offset += offsetDelta;
+        token.reach += offsetDelta;
+        token.line += lineDelta;
+    }
+
+    // 把间隙移到第 index 个单词前，跨过间隙的单词结算或减去平移
+    void moveGap(size_t index)
+    {
+        while (gapStart > index) {
+            ScanToken& token = buffer[--gapEnd] = buffer[--gapStart];
+            shift(token, -offsetShift, -lineShift);
+        }
+        while (gapStart < index) {
+            ScanToken& token = buffer[gapStart++] = buffer[gapEnd++];
+            shift(token, offsetShift, lineShift);
+        }
+    }
+
+    // 间隙不够放 size 个单词时扩大缓冲区，间隙之后的单词整体后移
+    void growGap(size_t size)
+    {
+        size_t tail = buffer.size() - gapEnd;
+        size_t grown = max(buffer.size() * 2, tokenCount() + size + 64);
+        buffer.resize(grown);
+        move_backward(buffer.begin() + gapEnd, buffer.begin() + gapEnd + tail, buffer.end());
+        gapEnd = grown - tail;
+    }
+
+    // [from, to) 中第一个结尾不小于 end 的单词
+    size_t findEnd(size_t from, size_t to, size_t end) const
+    {
+        while (from < to) {
+            size_t mid = (from + to) / 2;
+            ScanToken token = at(mid);
+            if (token.offset + token.length < end) from = mid + 1;
+            else to = mid;
+        }
+        return from;
+    }
+
+    DFAScanner dfa;
+    const LexLangProfile* profile = nullptr;
+    string text;
+    vector<ScanToken> buffer;   // 单词的间隙缓冲区，[gapStart, gapEnd) 为间隙
+    size_t gapStart = 0;
+    size_t gapEnd = 0;
+    ptrdiff_t offsetShift = 0;  // 间隙之后的单词还要加上的平移
+    int lineShift = 0;
+    size_t maxLookahead = 0;    // 单词结尾之后最多多读的字节数
+};
+
+/*============================二进制单词文件==================================*/
+
+// 数据是否为 .lexb 文件
+bool isLexbData(const char* data, size_t size);
+
+// 把 .lexb 文件的内容转成文本格式，用于查看
+string lexbToText(const char* data, size_t size, string& text);
+
+/*============================自动机缓存==================================*/
+
+// 规格化后的规则加上选项，写在缓存文件中，读入时逐字比较
+string automatonCacheSpec(const string& allRegex, bool lowerCase, NFAConstruction construction, bool perRule);
+
+// 缓存的键：automatonCacheSpec 的64位FNV-1a哈希，只用作文件名
+uint64_t automatonCacheKey(const string& spec);
+
+#endif // LEXCORE_H
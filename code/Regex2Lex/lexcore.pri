@@ -0,0 +1,11 @@
+# 词法分析器生成的核心算法，只依赖C++标准库
+# 图形界面 Regex2Lex.pro、命令行工具 cli/regex2lex.pro、性能测试 bench/regex2lex_bench.pro
+# 和回归测试 tests/regex2lex_test.pro 都包含这个文件
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/lexcore.cpp
+
+HEADERS += \
+    $$PWD/lexcore.h
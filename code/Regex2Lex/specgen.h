@@ -0,0 +1,96 @@
+﻿/****************************************************
+ * @FileName: specgen.h
+ * @Brief: 生成的压力规则
+ * @Module Function: 按名称和规模生成关键字、嵌套闭包、状态数指数增长和宽字符类规则，
+ *                   性能测试（bench/main.cpp）和回归测试（tests/main.cpp）共用
+ *
+ ****************************************************/
+#ifndef SPECGEN_H
+#define SPECGEN_H
+
+#include "lexcore.h"
+
+// 规则名称只能是字母（后面的数字是编码），第 k 个名称为 prefix 加上 A、B、...、Z、BA、BB ...
+inline string ruleName(const string& prefix, int k)
+{
+    string letters;
+    do {
+        letters.insert(letters.begin(), char('A' + k % 26));
+        k /= 26;
+    } while (k > 0);
+    return prefix + letters;
+}
+
+// 字节的 \xHH 写法
+inline string hexByte(int b)
+{
+    const char* hex = "0123456789ABCDEF";
+    return string("\\x") + hex[b >> 4] + hex[b & 15];
+}
+
+/*
+* @brief 长的关键字选择：n 个互不相同的小写单词放在一条多单词规则中，后面是标识符规则
+* 单词由固定种子的线性同余序列生成，每次运行相同。关键字都是标识符的前缀，DFA中关键字和标识符的状态交织在一起
+*/
+inline string keywordSpec(int n)
+{
+    set<string> seen;
+    string alternation;
+    uint32_t seed = 12345;
+    while ((int)seen.size() < n) {
+        seed = seed * 1103515245u + 12345u;
+        int length = 2 + (seed >> 16) % 8;
+        string word;
+        for (int i = 0; i < length; i++) {
+            seed = seed * 1103515245u + 12345u;
+            word += char('a' + (seed >> 16) % 26);
+        }
+        if (!seen.insert(word).second) continue;
+        if (!alternation.empty()) alternation += "|";
+        alternation += word;
+    }
+    return "letter=[A-Za-z]\n"
+           "digit=[0-9]\n"
+           "_KEYWORD200S=" + alternation + "\n"
+           "_ID101=letter(letter|digit)*\n";
+}
+
+// 深层嵌套的正闭包：((a)+b)+c)+... 共 n 层，Thompson构造中是一长串ε边
+inline string nestSpec(int n)
+{
+    string regex = "a";
+    for (int i = 1; i <= n; i++) {
+        regex = "(" + regex + ")+" + char('a' + i % 26);
+    }
+    return "_NEST100=" + regex + "\n";
+}
+
+// 状态数指数增长的 (a|b)*a(a|b){n}，有 2^(n+1) 个DFA状态；规则不支持 {n}，展开成 n 个 (a|b)
+inline string blowupSpec(int n)
+{
+    string regex = "(a|b)*a";
+    for (int i = 0; i < n; i++) {
+        regex += "(a|b)";
+    }
+    return "_X100=" + regex + "\n";
+}
+
+/*
+* @brief 宽字符类：n 条规则，每条是一个ASCII字节区间加一段汉字区间的字符类的正闭包
+* 各规则的区间错开一部分，字节原子划分和UTF-8区间转换都要处理大量互相重叠的区间
+*/
+inline string classesSpec(int n)
+{
+    string spec;
+    for (int k = 0; k < n; k++) {
+        int lo = 0x21 + k % 40;
+        int hi = 0x5E + k % 33;
+        int cpLo = 0x4E00 + k * 97;
+        int cpHi = cpLo + 2000 + k * 13;
+        spec += "_" + ruleName("CLASS", k) + to_string(300 + k) + "=[" + hexByte(lo) + "-" + hexByte(hi)
+              + encodeUtf8(cpLo) + "-" + encodeUtf8(cpHi) + "]+\n";
+    }
+    return spec;
+}
+
+#endif // SPECGEN_H
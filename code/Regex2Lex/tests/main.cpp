@@ -0,0 +1,567 @@
+﻿/****************************************************
+ * @FileName: main.cpp
+ * @Brief: 核心算法的回归测试 regex2lex_test
+ * @Module Function: 对比同一结果的不同算法：分块并行和串行的词法分析、增量分析和重新分析整个文本、
+ *                   多线程和串行的子集构造、按规则构造和子集构造的DFA、缓存读回的自动机等，
+ *                   有不同时输出出错的检查并返回1，全部通过时返回0
+ *
+ ****************************************************/
+#include "../lexcore.h"
+#include "../specgen.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+
+// 自带规则文件所在的目录，qmake 工程中设为源代码目录
+#ifndef REGEX2LEX_SPEC_DIR
+#define REGEX2LEX_SPEC_DIR ".."
+#endif
+
+/*============================检查和辅助函数==================================*/
+
+// 失败的检查个数
+int failures = 0;
+
+// 一项检查，失败时输出位置和说明
+void check(bool ok, const string& what, const char* file, int line)
+{
+    if (ok) return;
+    failures++;
+    fprintf(stderr, "%s:%d: FAILED: %s\n", file, line, what.c_str());
+}
+
+#define CHECK(cond, what) check((cond), (what), __FILE__, __LINE__)
+
+// 读入自带的规则文件
+string readSpec(const string& relativePath)
+{
+    string path = string(REGEX2LEX_SPEC_DIR) + "/" + relativePath;
+    ifstream stream(path, ios::binary);
+    if (!stream) {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        exit(2);
+    }
+    return string((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+}
+
+string tinySpec()
+{
+    return readSpec("tiny_regex.txt");
+}
+
+string miniCSpec()
+{
+    return readSpec("mini-c语言的测试/minic_regex.txt");
+}
+
+/*
+* @brief 和"开始分析"相同的流程：规则 -> NFA -> DFA -> 最小化DFA -> 字节等价类
+* 规则有错或DFA状态太多时返回空
+*/
+unique_ptr<LexerCompilation> compileSpec(const string& rules, bool lowerCase)
+{
+    unique_ptr<LexerCompilation> lc(new LexerCompilation);
+    lc->isLowerCase = lowerCase;
+    lc->subsetThreads = 1;
+    if (!lc->handleAllRegex(rules, lowerCase).empty()) return nullptr;
+    NFA nfa = lc->regex2NFA();
+    lc->splitSymbolAtoms();
+    if (!lc->NFA2DFA(nfa, eagerDFAStateLimit)) return nullptr;
+    lc->DFAminimize();
+    lc->DFAbyteClasses();
+    return lc;
+}
+
+// 两组单词完全相同
+bool sameTokens(const vector<ScanToken>& a, const vector<ScanToken>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].tag != b[i].tag || a[i].offset != b[i].offset || a[i].length != b[i].length ||
+            a[i].line != b[i].line || a[i].reach != b[i].reach) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 固定种子的伪随机数，每次运行相同
+struct TestRandom
+{
+    uint32_t seed;
+
+    explicit TestRandom(uint32_t s) : seed(s) {}
+
+    int next(int bound)
+    {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) % bound;
+    }
+};
+
+// 由片段随机拼成的Mini-C源程序，newlines 为假时不含换行
+string randomMiniC(TestRandom& random, int pieces, bool newlines)
+{
+    static const char* const fragments[] = {
+        "int", "float", "x1", "_y", "while", " ", "  ", "\t", "123", "4.56", "+", "++", "==", "=",
+        "<=", "!", "(", ")", "{", "}", "[", "]", ";", ",", "/*c*/", "/* a\nb */", "// line\n", "\n", "@", "."};
+    const int count = sizeof(fragments) / sizeof(fragments[0]);
+    string text;
+    while (pieces-- > 0) {
+        string piece = fragments[random.next(count)];
+        if (!newlines && piece.find('\n') != string::npos) continue;
+        text += piece;
+    }
+    return text;
+}
+
+/*============================分块并行词法分析==================================*/
+
+// 分块并行的结果要和串行分析完全相同，包括输入比块数还短和没有换行的情况
+void testParallelScan()
+{
+    unique_ptr<LexerCompilation> lc = compileSpec(miniCSpec(), false);
+    CHECK(lc != nullptr, "compile minic_regex.txt");
+    if (!lc) return;
+    DFAScanner dfa(*lc);
+
+    vector<string> inputs = {"", "x", "}+]\n}", "\n\n\n", "int x;\nx = 1;\n", "a b c d e f g h i j"};
+    TestRandom random(18);
+    for (int i = 0; i < 40; i++) {
+        inputs.push_back(randomMiniC(random, 1 + random.next(400), i % 2 == 0));
+    }
+
+    for (const string& input : inputs) {
+        vector<ScanToken> serial = scanSource(dfa, miniCProfile, input.data(), input.size());
+        for (int chunks = 1; chunks <= 9; chunks++) {
+            int relexCount = 0;
+            vector<ScanToken> parallel = scanSourceParallel(dfa, miniCProfile, input.data(), input.size(), chunks, relexCount);
+            CHECK(sameTokens(serial, parallel),
+                  "scanSourceParallel with " + to_string(chunks) + " chunks on \"" + input.substr(0, 40) + "\"");
+        }
+    }
+}
+
+/*============================增量词法分析==================================*/
+
+// 增量分析的全部单词
+vector<ScanToken> incrementalTokens(const IncrementalLexer& lexer)
+{
+    vector<ScanToken> tokens;
+    for (size_t i = 0; i < lexer.tokenCount(); i++) {
+        tokens.push_back(lexer.at(i));
+    }
+    return tokens;
+}
+
+// 随机修改若干次，每次修改后的增量分析结果都要和重新分析整个文本相同
+void checkIncremental(const LexerCompilation& lc, const LexLangProfile& profile, const string& name, uint32_t seed)
+{
+    TestRandom random(seed);
+    IncrementalLexer lexer;
+    lexer.reset(lc, randomMiniC(random, 200, true), profile);
+    DFAScanner dfa(lc);
+    for (int step = 0; step < 300; step++) {
+        const string& text = lexer.source();
+        size_t start = random.next(text.size() + 1);
+        size_t removed = random.next(min<size_t>(text.size() - start, 12) + 1);
+        string inserted = random.next(3) == 0 ? "" : randomMiniC(random, 1 + random.next(4), true);
+        lexer.edit(start, removed, inserted);
+
+        const string& edited = lexer.source();
+        vector<ScanToken> full = scanSource(dfa, profile, edited.data(), edited.size());
+        if (!sameTokens(full, incrementalTokens(lexer))) {
+            CHECK(false, name + ": edit " + to_string(step) + " at " + to_string(start) + " differs from a full rescan");
+            return;
+        }
+    }
+}
+
+void testIncrementalLexer()
+{
+    unique_ptr<LexerCompilation> miniC = compileSpec(miniCSpec(), false);
+    unique_ptr<LexerCompilation> tiny = compileSpec(tinySpec(), true);
+    CHECK(miniC && tiny, "compile the bundled specs");
+    if (!miniC || !tiny) return;
+    for (uint32_t seed = 1; seed <= 10; seed++) {
+        checkIncremental(*miniC, miniCProfile, "minic seed " + to_string(seed), seed);
+        checkIncremental(*tiny, tinyProfile, "tiny seed " + to_string(seed), seed);
+    }
+}
+
+/*============================并行子集构造==================================*/
+
+// 规则 -> NFA -> 子集构造，返回是否构造出完整的DFA
+bool subsetDFA(LexerCompilation& lc, const string& rules, NFAConstruction construction, int threads, int maxStates)
+{
+    lc.nfaConstruction = construction;
+    lc.subsetThreads = threads;
+    if (!lc.handleAllRegex(rules, false).empty()) return false;
+    NFA nfa = lc.regex2NFA();
+    lc.splitSymbolAtoms();
+    return lc.NFA2DFA(nfa, maxStates);
+}
+
+// 两个子集构造的结果完全相同：状态编号、标志、标记、转移和状态集合
+bool sameSubsetDFA(const LexerCompilation& a, const LexerCompilation& b)
+{
+    if (a.dfaTable.size() != b.dfaTable.size() || a.dfaEndStatusSet != b.dfaEndStatusSet ||
+        a.dfaNotEndStatusSet != b.dfaNotEndStatusSet) {
+        return false;
+    }
+    for (size_t i = 0; i < a.dfaTable.size(); i++) {
+        const dfaNode& x = a.dfaTable[i];
+        const dfaNode& y = b.dfaTable[i];
+        if (x.flag != y.flag || x.tag != y.tag || x.transitions != y.transitions ||
+            a.dfaNFAStates(i + 1) != b.dfaNFAStates(i + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 多线程子集构造的结果要和串行构造完全相同，状态数超过上限时同样放弃
+void testParallelSubsets()
+{
+    vector<pair<string, string>> specs = {
+        {"minic", miniCSpec()}, {"blowup12", blowupSpec(12)}, {"keywords1500", keywordSpec(1500)}};
+    for (const auto& spec : specs) {
+        for (NFAConstruction construction : {NFA_THOMPSON, NFA_GLUSHKOV}) {
+            string name = spec.first + (construction == NFA_GLUSHKOV ? " glushkov" : " thompson");
+            LexerCompilation serial;
+            CHECK(subsetDFA(serial, spec.second, construction, 1, -1), name + ": serial subset construction");
+            for (int threads : {2, 4, 8}) {
+                LexerCompilation parallel;
+                CHECK(subsetDFA(parallel, spec.second, construction, threads, -1) && sameSubsetDFA(serial, parallel),
+                      name + ": " + to_string(threads) + " threads differ from the serial construction");
+            }
+        }
+    }
+
+    // 超过上限：串行和并行都返回false并清空表
+    for (int threads : {1, 4}) {
+        LexerCompilation lc;
+        bool complete = subsetDFA(lc, blowupSpec(13), NFA_THOMPSON, threads, 5000);
+        CHECK(!complete && lc.dfaTable.empty(), to_string(threads) + " threads: state limit not enforced");
+    }
+}
+
+/*============================按规则构造DFA==================================*/
+
+// 规则 -> 按规则构造或子集构造 -> 最小化DFA
+unique_ptr<LexerCompilation> minimalDFA(const string& rules, bool lowerCase, bool perRule, RuleDFACache* cache)
+{
+    unique_ptr<LexerCompilation> lc(new LexerCompilation);
+    lc->isLowerCase = lowerCase;
+    lc->subsetThreads = 1;
+    if (!lc->handleAllRegex(rules, lowerCase).empty()) return nullptr;
+    NFA nfa = lc->regex2NFA();
+    lc->splitSymbolAtoms();
+    bool complete = perRule ? lc->rules2DFA(cache, eagerDFAStateLimit) : lc->NFA2DFA(nfa, eagerDFAStateLimit);
+    if (!complete) return nullptr;
+    lc->DFAminimize();
+    return lc;
+}
+
+// 两个最小化DFA同构：从初态同时按字节走，状态一一对应且接受的单词标记相同
+bool sameMinimalDFA(const LexerCompilation& a, const LexerCompilation& b)
+{
+    vector<vector<int>> rowsA = a.dfaMinByteRows();
+    vector<vector<int>> rowsB = b.dfaMinByteRows();
+    if (rowsA.size() != rowsB.size()) return false;
+    vector<int> tagA(rowsA.size(), -1), tagB(rowsB.size(), -1);
+    for (const dfaMinNode& node : a.dfaMinTable) tagA[node.id] = node.tag;
+    for (const dfaMinNode& node : b.dfaMinTable) tagB[node.id] = node.tag;
+
+    vector<int> toB(rowsA.size(), -1), toA(rowsB.size(), -1);
+    vector<int> pending = {a.dfaMinStartState()};
+    toB[a.dfaMinStartState()] = b.dfaMinStartState();
+    toA[b.dfaMinStartState()] = a.dfaMinStartState();
+    while (!pending.empty()) {
+        int s = pending.back();
+        pending.pop_back();
+        int t = toB[s];
+        if (tagA[s] != tagB[t]) return false;
+        for (int c = 0; c < 256; c++) {
+            int x = rowsA[s][c], y = rowsB[t][c];
+            if ((x == -1) != (y == -1)) return false;
+            if (x == -1) continue;
+            if (toB[x] == -1 && toA[y] == -1) {
+                toB[x] = y;
+                toA[y] = x;
+                pending.push_back(x);
+            } else if (toB[x] != y || toA[y] != x) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 字母表 {a,b,c} 上的随机正则表达式
+string randomRegex(TestRandom& random, int depth)
+{
+    int choice = depth == 0 ? 0 : random.next(5);
+    switch (choice) {
+    case 1:
+        return randomRegex(random, depth - 1) + randomRegex(random, depth - 1);
+    case 2:
+        return randomRegex(random, depth - 1) + "|" + randomRegex(random, depth - 1);
+    case 3:
+        return "(" + randomRegex(random, depth - 1) + ")" + "*+?"[random.next(3)];
+    default:
+        return string(1, char('a' + random.next(3)));
+    }
+}
+
+// 随机的若干条规则，名称可能重复，多单词规则的各分支是不同的单词
+string randomRuleSpec(TestRandom& random)
+{
+    static const char* const names[] = {"_A", "_B", "_C"};
+    string rules;
+    int count = 1 + random.next(5);
+    for (int i = 0; i < count; i++) {
+        string name = names[random.next(3)] + to_string(100 * (i + 1));
+        if (random.next(2) == 0) {
+            rules += name + "S=" + randomRegex(random, 0);
+            for (int k = random.next(3); k >= 0; k--) {
+                rules += "|" + randomRegex(random, 1);
+            }
+        } else {
+            rules += name + "=" + randomRegex(random, 3);
+        }
+        rules += "\n";
+    }
+    return rules;
+}
+
+// 按规则构造的最小化DFA要和子集构造的相同，包括规则名重复的情况；没有改动的规则使用缓存
+void testRuleDFAs()
+{
+    vector<pair<string, string>> specs = {
+        {"tiny", tinySpec()},
+        {"minic", miniCSpec()},
+        {"duplicate names", "_OP400S=a|b\n_OP500S=c|d|e\n_X200=x\n_X300S=y|z\n_OP600=ab+\n"}};
+    TestRandom random(24);
+    for (int i = 0; i < 60; i++) {
+        specs.push_back({"random " + to_string(i), randomRuleSpec(random)});
+    }
+    for (const auto& spec : specs) {
+        bool lowerCase = spec.first == "tiny";
+        unique_ptr<LexerCompilation> subset = minimalDFA(spec.second, lowerCase, false, nullptr);
+        unique_ptr<LexerCompilation> perRule = minimalDFA(spec.second, lowerCase, true, nullptr);
+        CHECK(subset && perRule && sameMinimalDFA(*subset, *perRule),
+              spec.first + ": rules2DFA differs from the subset construction\n" + spec.second);
+    }
+
+    // 第二次编译全部从缓存取得，改动一条规则后只重新构造这一条
+    RuleDFACache cache;
+    string rules = miniCSpec();
+    unique_ptr<LexerCompilation> first = minimalDFA(rules, false, true, &cache);
+    unique_ptr<LexerCompilation> again = minimalDFA(rules, false, true, &cache);
+    CHECK(first && again && again->ruleDFAsBuilt == 0 && again->ruleDFAsReused == first->ruleDFAsBuilt,
+          "unchanged rules are not reused from the cache");
+    size_t pos = rules.find("_NUM");
+    CHECK(pos != string::npos, "minic_regex.txt has a _NUM rule");
+    if (pos == string::npos) return;
+    rules.insert(rules.find('=', pos) + 1, "0x(digit)+|");
+    unique_ptr<LexerCompilation> edited = minimalDFA(rules, false, true, &cache);
+    unique_ptr<LexerCompilation> expected = minimalDFA(rules, false, false, nullptr);
+    CHECK(edited && edited->ruleDFAsBuilt == 1, "editing one rule rebuilds more than that rule");
+    CHECK(edited && expected && sameMinimalDFA(*edited, *expected), "cached rules2DFA differs after an edit");
+}
+
+/*============================自动机缓存==================================*/
+
+// 读入缓存后用到各表的操作：词法分析（完整的DFA和按需构造的DFA）、生成两种程序、显示DFA状态
+void useAutomaton(const LexerCompilation& lc, const string& input)
+{
+    DFAScanner dfa(lc);
+    scanSource(dfa, miniCProfile, input.data(), input.size());
+    LazyDFA lazy(lc, 1 << 16);
+    scanSource(lazy, miniCProfile, input.data(), input.size());
+    lc.generateLexer(1, LEXER_TABLE);
+    lc.generateLexer(1, LEXER_DIRECT);
+    for (size_t i = 1; i <= lc.dfaTable.size(); i++) {
+        lc.dfaStateLabel(i);
+    }
+}
+
+// 两组规则的名称、正则表达式、编码和单词标记都相同
+bool sameRules(const vector<TokenRule>& a, const vector<TokenRule>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].name != b[i].name || a[i].regex != b[i].regex || a[i].code != b[i].code || a[i].multi != b[i].multi ||
+            a[i].firstTag != b[i].firstTag || a[i].tagCount != b[i].tagCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 对读回的表做一处改动，改动后重新写出的缓存必须被拒绝
+struct CacheCorruption
+{
+    const char* what;
+    void (*apply)(LexerCompilation& lc);
+};
+
+const CacheCorruption cacheCorruptions[] = {
+    {"missing closure row", [](LexerCompilation& lc) { lc.closureRowOf.pop_back(); }},
+    {"no closure rows", [](LexerCompilation& lc) { lc.closureRowOf.clear(); }},
+    {"closure bit past the last NFA state",
+     [](LexerCompilation& lc) {
+         int s = lc.nfaArena.stateCount;
+         if (s % 64 != 0) lc.closureBits[s / 64] |= 1ULL << (s % 64);
+     }},
+    {"atom outside dfaCharSet",
+     [](LexerCompilation& lc) {
+         for (int sym = 0; sym < (int)lc.symbolTable.size(); sym++) {
+             if (!lc.dfaCharSet.count(sym)) {
+                 lc.symbolAtoms[0].push_back(sym);
+                 return;
+             }
+         }
+     }},
+    {"no NFA start state", [](LexerCompilation& lc) { lc.startNFAstatus.clear(); }},
+    {"bucket past the state sets",
+     [](LexerCompilation& lc) { lc.dfaStateSets.buckets[0] = lc.dfaStateSets.size() + 5; }},
+    {"bucket table not a power of two", [](LexerCompilation& lc) { lc.dfaStateSets.buckets.resize(3); }},
+    {"rule tags past acceptTags",
+     [](LexerCompilation& lc) { lc.regexToGenerate.back().firstTag = lc.acceptTags.size(); }},
+};
+
+// 缓存读回后的分析结果和原来相同；改坏的缓存要么被拒绝，要么读入后使用时不越界
+void testAutomatonCache()
+{
+    TestRandom random(20);
+    string input = randomMiniC(random, 300, true);
+    for (bool perRule : {false, true}) {
+        string name = perRule ? "minic per rule" : "minic";
+        unique_ptr<LexerCompilation> lc = minimalDFA(miniCSpec(), false, perRule, nullptr);
+        CHECK(lc != nullptr, name + ": compile");
+        if (!lc) continue;
+        lc->DFAbyteClasses();
+        string spec = automatonCacheSpec(miniCSpec(), false, NFA_THOMPSON, perRule);
+        string blob = lc->saveAutomaton(spec);
+
+        LexerCompilation loaded;
+        CHECK(loaded.loadAutomaton(blob.data(), blob.size(), spec).empty(), name + ": cache does not load back");
+        CHECK(loaded.varDefMap == lc->varDefMap && sameRules(loaded.regexToGenerate, lc->regexToGenerate),
+              name + ": rules are not restored from the cache");
+        DFAScanner a(*lc), b(loaded);
+        CHECK(sameTokens(scanSource(a, miniCProfile, input.data(), input.size()),
+                         scanSource(b, miniCProfile, input.data(), input.size())),
+              name + ": loaded automaton scans differently");
+        // 文件名相同（哈希碰撞）而规则不同时不能读入
+        LexerCompilation other;
+        CHECK(!other.loadAutomaton(blob.data(), blob.size(), spec + "_X1=x\n").empty(),
+              name + ": cache for other rules accepted");
+
+        for (const CacheCorruption& corruption : cacheCorruptions) {
+            LexerCompilation changed;
+            changed.loadAutomaton(blob.data(), blob.size(), spec);
+            corruption.apply(changed);
+            string bad = changed.saveAutomaton(spec);
+            LexerCompilation corrupt;
+            CHECK(!corrupt.loadAutomaton(bad.data(), bad.size(), spec).empty(),
+                  name + ": cache with " + corruption.what + " accepted");
+        }
+
+        int accepted = 0;
+        for (int i = 0; i < 3000; i++) {
+            string bad = blob;
+            if (i % 10 == 0) {
+                bad.resize(random.next(bad.size()));
+            } else {
+                for (int k = 1 + random.next(4); k > 0; k--) {
+                    bad[random.next(bad.size())] ^= char(1 << random.next(8));
+                }
+            }
+            LexerCompilation corrupt;
+            if (corrupt.loadAutomaton(bad.data(), bad.size(), spec).empty()) {
+                accepted++;
+                useAutomaton(corrupt, input);
+            }
+        }
+        CHECK(accepted < 3000, name + ": corrupted caches are all accepted");
+    }
+}
+
+/*============================生成的转移表==================================*/
+
+/*
+* @brief 检查表驱动程序的 yy_next：元素类型放得下每个状态编号，状态编号都小于状态数，
+* 死状态写作 YY_DEAD，返回错误信息，空串表示没有问题
+*/
+string checkTransitionTable(const string& code, int stateNum)
+{
+    bool wide = code.find("static const uint32_t yy_next[") != string::npos;
+    if (!wide && code.find("static const uint16_t yy_next[") == string::npos) return "no yy_next table";
+    string dead = wide ? "#define YY_DEAD 0xFFFFFFFFu" : "#define YY_DEAD 0xFFFF";
+    if (code.find(dead) == string::npos) return "YY_DEAD does not match the element type";
+    long long limit = wide ? 0xFFFFFFFFLL : 0xFFFFLL;
+    if (stateNum >= limit) return "state numbers reach YY_DEAD";
+
+    size_t pos = code.find("yy_next[YY_NUM_STATES][YY_NUM_CLASSES] = {");
+    size_t end = code.find("};", pos);
+    for (pos = code.find('{', pos) + 1; pos < end; pos++) {
+        if (!isdigit((unsigned char)code[pos])) continue;
+        char* after = nullptr;
+        long long state = strtoll(code.c_str() + pos, &after, 10);
+        if (state >= stateNum) return "entry " + to_string(state) + " is not a state";
+        pos = after - code.c_str();
+    }
+    return "";
+}
+
+// 状态数超过 uint16_t 时表驱动程序改用 uint32_t，状态编号不会回绕或和 YY_DEAD 重合
+void testLexerTables()
+{
+    vector<pair<string, string>> specs = {{"minic", miniCSpec()}, {"blowup16", blowupSpec(16)}};
+    for (const auto& spec : specs) {
+        unique_ptr<LexerCompilation> lc = compileSpec(spec.second, false);
+        CHECK(lc != nullptr, spec.first + ": compile");
+        if (!lc) continue;
+        int stateNum = lc->dfaMinTable.size();
+        string error = checkTransitionTable(lc->generateLexer(1, LEXER_TABLE), stateNum);
+        CHECK(error.empty(), spec.first + " (" + to_string(stateNum) + " states): " + error);
+    }
+}
+
+/*============================入口==================================*/
+
+struct TestCase
+{
+    const char* name;
+    void (*run)();
+};
+
+const TestCase testCases[] = {
+    {"parallel-scan", testParallelScan},
+    {"incremental-lexer", testIncrementalLexer},
+    {"parallel-subsets", testParallelSubsets},
+    {"rule-dfas", testRuleDFAs},
+    {"automaton-cache", testAutomatonCache},
+    {"lexer-tables", testLexerTables},
+};
+
+// 不带参数时运行全部测试，否则只运行给出名称的测试
+int main(int argc, char* argv[])
+{
+    for (const TestCase& test : testCases) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            if (string(argv[i]) == test.name) selected = true;
+        }
+        if (!selected) continue;
+        int before = failures;
+        test.run();
+        printf("%-24s %s\n", test.name, failures == before ? "ok" : "FAILED");
+    }
+    printf("%d failed checks\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+# 核心算法的回归测试 regex2lex_test：对比同一结果的不同算法，有不同时返回1
+# 不使用Qt库，也不需要图形环境
+
+TEMPLATE = app
+TARGET = regex2lex_test
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+# 自带的 tiny_regex.txt 和 minic_regex.txt 从源代码目录读入
+DEFINES += REGEX2LEX_SPEC_DIR=\\\"$$PWD/..\\\"
+
+SOURCES += \
+    main.cpp
+
+# 和性能测试共用的压力规则生成
+HEADERS += \
+    ../specgen.h
+
+include(../lexcore.pri)
@@ -15,6 +15,7 @@
  ****************************************************/
 #include "widget.h"
 #include "ui_widget.h"
+#include "lexcore.h"
 #include <QString>
 #include <QFile>
 #include <QTextStream>
@@ -23,2019 +24,380 @@
 // #include <QTextCodec> // Qt6已移除，不再需要
 #include <QMessageBox>
 #include <QHeaderView>   // 新增：用于操作表头大小调整
-#include <QProcess>      // 新增：用于编译和运行
-#include <iostream>
-#include <map>
-#include <vector>
-#include <stack>
-#include <unordered_map>
-#include <queue>
-#include <set>
-#include <unordered_set>
-#include <algorithm>
-#include <string>
-#include <sstream>
-#include <fstream>
+#include <QElapsedTimer>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 // 如果源文件本身是UTF-8，这一行通常不是必须的，但在Windows MSVC下有助于识别字符串字面量
 #pragma execution_character_set("utf-8")
 
-using namespace std;
-
-// EPSILON定义
-const char EPSILON = '#';
-
-// 下面map防止字符冲突
-// 符号->字符串map (用于显示)
-map<char, string> m1 = { {(char)3, "+"},{(char)4, "|"},{(char)5, "("},{(char)6, ")"},{(char)7, "*"},{(char)8, "-"},{(char)16, "?"},{(char)17, "["},{(char)18, "]"},{ (char)19,"~"}, {(char)20,"\n"}};
-// 字符串->符号map (用于转义特殊字符)
-map<string, char> m2 = { {"\\+", (char)3 },{"\\|", (char)4 },{ "\\(", (char)5},{ "\\)" ,(char)6},{"\\*" ,(char)7},{"\\-", (char)8},{ "\\?",(char)16},{"\\[", (char)17},{"\\]", (char)18 }, {"\\~", (char)19} };
-
-// 变量名->特殊字符映射 (动态生成，如 letter -> (char)100, digit -> (char)101)
-map<string, char> varCharMap;
-// 特殊字符->变量名映射 (反向映射，用于显示)
-map<char, string> charVarMap;
-// 下一个可用的特殊字符编码
-char nextVarChar = (char)100;
-
-// 变量定义表 (如 letter=[A-Za-z])
-map<string, string> varDefMap;
-// 需要生成DFA的正则表达式列表 (以_开头的)
-vector<pair<string, string>> regexToGenerate; // <名称, 正则表达式>
-// 单词编码表
-map<string, int> tokenCodeMap;
-// 多单词标记 (以S结尾的定义，值为true表示是多单词)
-map<string, bool> multiTokenMap;
-// 多单词的各个token列表
-map<string, vector<string>> multiTokenList;
-
-// 正则表达式行合集
-QString regexLine[5];
-// 生成NFA和DFA的正则表达式
-string finalRegex;
-
-// 关键词合集
-set<string> keyWords;
-// 操作符号map
-map<string,string> opMap;
-
-// 注释符号集合，0为开始符号，1为结束符号
-string commentSymbol[2];
-
-// 全局结点计数器
-int nodeCount = 0;
-
-// 是否忽略大小写（默认不忽略）
-bool isLowerCase = false;
-
-// 全局字符统计
-set<char> nfaCharSet;
-set<char> dfaCharSet;
-
+// 正则表达式的处理、自动机的构造和代码生成都在 lexcore.cpp 中，这里只有界面和文件读写
 
 Widget::Widget(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::Widget)
     , m_lexerPath()
-    , m_exePath()
+    , m_liveLexer(nullptr)
+    , m_comp(new LexerCompilation)
+    , m_analysis(new QFutureWatcher<AnalysisResult>(this))
+    , m_ruleCache(new RuleDFACache)
+    , m_compile(new QProcess(this))
 {
     ui->setupUi(this);
-}
 
-Widget::~Widget()
-{
-    delete ui;
-}
+    // 核心算法的调试信息输出到 qDebug
+    coreDebugSink = [](const string& message) { qDebug().noquote() << QString::fromStdString(message); };
 
-/*
-* @brief 模拟trim函数
-* 用于结果展示
-*/
-string trim(const string& str)
-{
-    if (str.empty() || str == "\\n")
-    {
-        return str;
-    }
-    string ret(str);
-    ret.erase(0, ret.find_first_not_of("\\"));
-    ret.erase(ret.find_last_not_of("\\") + 1);
-    return ret;
-}
+    // 后台分析结束后在界面线程中换上新的结果
+    connect(m_analysis, &QFutureWatcher<AnalysisResult>::finished, this, &Widget::analysisFinished);
 
-/*
-* @brief set转string
-* 用于结果展示
-*/
-string set2string(set<int> s)
-{
-    string result;
-
-    for (int i : s) {
-        result.append(to_string(i));
-        result.append(",");
-    }
-
-    if (result.size() != 0)
-        result.pop_back(); //弹出最后一个逗号
+    // 后台编译结束或 gcc 无法启动时输出结果
+    connect(m_compile, &QProcess::finished, this, &Widget::compileFinished);
+    connect(m_compile, &QProcess::errorOccurred, this, &Widget::compileFailed);
 
-    return result;
+    // 源程序编辑框每次修改后增量分析
+    connect(ui->plainTextEdit_src->document(), &QTextDocument::contentsChange, this, &Widget::liveSourceChanged);
 }
 
-/*
-* @brief 获取关键词列表
-*/
-void getKeyWords(QString regex) {
-    string r = regex.toStdString();
-    QStringList t = regex.split("|");
-    for (QString s : t) {
-        keyWords.insert(s.toStdString());
-    }
-}
-
-/*
-* @brief 获取操作符号的名称
-*/
-string getOpName(QString regex1, QString regex2) {
-    QStringList op = regex1.split("|");
-    QStringList opName = regex2.split("|");
-    if (op.size() != opName.size()) {
-        return "操作符和操作符名称个数不一致！";
-    }
-    for (int i = 0; i < op.size(); i++) {
-        opMap[op[i].toStdString()] = opName[i].toStdString();
-    }
-    return "";
-}
-
-/*
-* @brief 获取注释符号
-*/
-string getCommentSymbol(QString& regex) {
-    QStringList t = regex.split("~");
-    if (t.size() != 2) return "注释输入格式错误";
-    commentSymbol[0] = t[0].toStdString();
-    commentSymbol[1] = t[1].toStdString();
-    regex = t[0] + "~*" + t[1];
-    return "";
-}
-
-/*
-* @brief 判断是不是字符
-* 由于前面已经对出现在下面的字符进行了希腊字母转换，所以一定不会出现下面的字符
-*/
-bool isChar(char c)
-{
-    if (!(c == '+' || c == '[' || c == ']' || c == '|' || c == '*' || c == '(' || c == ')' || c == '?' || c == '@'))
-        return true;
-    return false;
-}
+/*============================文件读写==================================*/
 
 /*
-* @brief 进一步处理正则表达式
-* 处理[] + 添加连接符
+* @brief 只读映射的源文件
+* 用 QFile::map 把文件映射到内存，扫描器直接在映射上运行，不把文件读进缓冲区
 */
-QString afterHandleRegex(QString regex)
+class MappedSource
 {
-    string regexStd = regex.toStdString();
-    qDebug() << "enter handleRegex: " << regex;
-
-    // 处理中括号
-    string result;
-    bool insideBrackets = false;
-    string currentString;
-
-    for (char c : regexStd) {
-        if (c == ' ') continue;
-        if (c == '[') {
-            insideBrackets = true;
-            currentString.push_back('(');
-        }
-        else if (c == ']') {
-            insideBrackets = false;
-            currentString.push_back(')');
-            result += currentString;
-            currentString.clear();
-        }
-        else if (insideBrackets) {
-            if (currentString.length() > 1) {
-                currentString.push_back('|');
-            }
-            currentString.push_back(c);
-        }
-        else {
-            result.push_back(c);
-        }
-    }
-
-    regexStd = result;
+public:
+    explicit MappedSource(const QString& path) : file(path), bytes(nullptr), length(0) {}
 
-    //先处理+号
-    for (int i = 0; i < regexStd.size(); i++)
+    ~MappedSource()
     {
-        if (regexStd[i] == '+')
-        {
-            int kcount = 0;
-            int j = i;
-            do
-            {
-                j--;
-                if (regexStd[j] == ')')
-                {
-                    kcount++;
-                }
-                else if (regexStd[j] == '(')
-                {
-                    kcount--;
-                }
-            } while (kcount != 0);
-            string str1 = regexStd.substr(0, j);
-            string kstr = regexStd.substr(j, i - j);
-            string str2 = regexStd.substr(i + 1, (regexStd.size() - i));
-            regexStd = str1 + kstr + kstr + "*" + str2;
-        }
+        if (bytes) file.unmap(bytes);
     }
 
-    for (int i = 0; i < regexStd.size() - 1; i++)
+    // 打开并映射文件，失败时返回错误信息
+    string open()
     {
-        if (isChar(regexStd[i]) && isChar(regexStd[i + 1])
-            || isChar(regexStd[i]) && regexStd[i + 1] == '('
-            || regexStd[i] == ')' && isChar(regexStd[i + 1])
-            || regexStd[i] == ')' && regexStd[i + 1] == '('
-            || regexStd[i] == '*' && regexStd[i + 1] != ')' && regexStd[i + 1] != '|' && regexStd[i + 1] != '?'
-            || regexStd[i] == '?' && regexStd[i + 1] != ')'
-            || regexStd[i] == '+' && regexStd[i + 1] != ')')
-        {
-            string str1 = regexStd.substr(0, i + 1);
-            string str2 = regexStd.substr(i + 1, (regexStd.size() - i));
-            str1 += "@";
-            regexStd = str1 + str2;
-        }
-
-    }
-    return QString::fromStdString(regexStd);
-}
-
-/*
-* @brief 对正则表达式进行处理
-* 新格式：
-* 变量定义: name=regex (如 letter=[A-Za-z], digit=[0-9])
-* 生成DFA: _name数字=regex (如 _ID101=letter(letter|digit)*)
-* 说明：
-* (1) 通过命名中加下划线(_)来表示该正则表达式需要生成DFA图
-* (2) 命名中的名字后的数值为对应单词的编码
-* (3) 命名中数值后加S表示后面有多个单词，编码从该数值开始
-* (4) 支持转义符号：\+ \| \( \) \* \- \? \[ \] \~
-*/
-string handleAllRegex(QString allRegex, bool isLowerCase) {
-    // 清空变量表
-    varDefMap.clear();
-    regexToGenerate.clear();
-    tokenCodeMap.clear();
-    multiTokenMap.clear();
-    multiTokenList.clear();
-
-    // 不区分大小写的话，全部转为小写
-    if (isLowerCase) {
-        allRegex = allRegex.toLower();
-    }
-
-    // 将文本内容按行分割
-    QStringList lines = allRegex.split("\n", Qt::SkipEmptyParts);
-
-    if (lines.isEmpty()) {
-        return "输入为空，请输入正则表达式！";
-    }
-
-    // 第一遍：解析变量定义和需要生成的正则表达式
-    for (const QString& line : lines) {
-        QString trimmedLine = line.trimmed();
-        if (trimmedLine.isEmpty()) continue;
-
-        // 查找等号位置（第一个等号）
-        int eqPos = trimmedLine.indexOf('=');
-        if (eqPos == -1) {
-            return "格式错误：每行必须是 name=regex 格式，错误行: " + trimmedLine.toStdString();
+        if (!file.open(QIODevice::ReadOnly)) {
+            return "无法打开源文件：" + file.errorString().toStdString();
         }
-
-        QString name = trimmedLine.left(eqPos).trimmed();
-        QString regex = trimmedLine.mid(eqPos + 1).trimmed();
-
-        if (name.isEmpty() || regex.isEmpty()) {
-            return "格式错误：名称或正则表达式为空，错误行: " + trimmedLine.toStdString();
+        length = file.size();
+        if (length == 0) {
+            return "";  // 空文件不能映射
         }
-
-        string nameStr = name.toStdString();
-        string regexStr = regex.toStdString();
-
-        // 判断是否以_开头（需要生成DFA）
-        if (nameStr[0] == '_') {
-            // 提取名称和编码，格式: _NAME123 或 _NAME123S
-            string pureName = nameStr.substr(1); // 去掉下划线
-            string tokenName;
-            int tokenCode = 0;
-            bool hasS = false;
-
-            // 查找数字开始位置
-            size_t numStart = string::npos;
-            for (size_t i = 0; i < pureName.size(); i++) {
-                if (isdigit(pureName[i])) {
-                    numStart = i;
-                    break;
-                }
-            }
-
-            if (numStart != string::npos) {
-                tokenName = pureName.substr(0, numStart);
-                string numPart = pureName.substr(numStart);
-                // 检查是否以S结尾（多单词标记）
-                if (!numPart.empty() && (numPart.back() == 'S' || numPart.back() == 's')) {
-                    hasS = true;
-                    numPart.pop_back();
-                }
-                if (!numPart.empty()) {
-                    tokenCode = stoi(numPart);
-                }
-            } else {
-                tokenName = pureName;
-            }
-
-            // 如果是多单词定义（以S结尾），解析各个单词
-            if (hasS) {
-                multiTokenMap[tokenName] = true;
-                // 按 | 分割多个单词（注意空格）
-                QStringList tokens = regex.split("|");
-                vector<string> tokenList;
-                for (const QString& t : tokens) {
-                    QString trimmed = t.trimmed();
-                    if (!trimmed.isEmpty()) {
-                        tokenList.push_back(trimmed.toStdString());
-                    }
-                }
-                multiTokenList[tokenName] = tokenList;
-                qDebug() << "多单词定义: " << QString::fromStdString(tokenName)
-                         << " 起始编码: " << tokenCode
-                         << " 单词数: " << tokenList.size();
-                for (size_t i = 0; i < tokenList.size(); i++) {
-                    qDebug() << "  单词" << i << ": " << QString::fromStdString(tokenList[i])
-                             << " 编码: " << (tokenCode + (int)i);
-                }
-            }
-
-            regexToGenerate.push_back({tokenName, regexStr});
-            tokenCodeMap[tokenName] = tokenCode;
-            qDebug() << "需要生成DFA: " << QString::fromStdString(tokenName)
-                     << " 编码: " << tokenCode
-                     << " 多单词: " << hasS
-                     << " 正则: " << QString::fromStdString(regexStr);
-        } else {
-            // 普通变量定义
-            varDefMap[nameStr] = regexStr;
-            qDebug() << "变量定义: " << QString::fromStdString(nameStr)
-                     << " = " << QString::fromStdString(regexStr);
+        bytes = file.map(0, length);
+        if (!bytes) {
+            return "无法映射源文件：" + file.errorString().toStdString();
         }
+        return "";
     }
 
-    if (regexToGenerate.empty()) {
-        return "没有找到需要生成DFA的正则表达式（以_开头的定义）！";
-    }
-
-    // 为每个变量分配一个特殊字符
-    varCharMap.clear();
-    charVarMap.clear();
-    nextVarChar = (char)100;
-    for (const auto& var : varDefMap) {
-        char c = nextVarChar++;
-        varCharMap[var.first] = c;
-        charVarMap[c] = var.first;
-        m1[c] = var.first;  // 添加到显示映射
-        qDebug() << "变量映射: " << QString::fromStdString(var.first)
-                 << " -> char(" << (int)c << ")";
-    }
-
-    // 第二遍：将变量名替换为对应的特殊字符（不展开定义）
-    auto replaceVariables = [](string regex, const map<string, char>& vars) -> string {
-        string result = regex;
-        // 按变量名长度降序排序，避免短变量名匹配到长变量名的一部分
-        vector<pair<string, char>> sortedVars(vars.begin(), vars.end());
-        sort(sortedVars.begin(), sortedVars.end(),
-             [](const auto& a, const auto& b) { return a.first.length() > b.first.length(); });
-
-        for (const auto& var : sortedVars) {
-            size_t pos = 0;
-            while ((pos = result.find(var.first, pos)) != string::npos) {
-                // 检查是否是独立的变量名（前后不是字母数字下划线）
-                bool validStart = (pos == 0) || (!isalnum(result[pos-1]) && result[pos-1] != '_');
-                bool validEnd = (pos + var.first.length() >= result.length()) ||
-                               (!isalnum(result[pos + var.first.length()]) && result[pos + var.first.length()] != '_');
-                if (validStart && validEnd) {
-                    result.replace(pos, var.first.length(), string(1, var.second));
-                    pos += 1;
-                } else {
-                    pos++;
-                }
-            }
-        }
-        return result;
-    };
-
-    // 替换所有需要生成的正则表达式中的变量名为特殊字符
-    QString combinedRegex;
-    for (size_t i = 0; i < regexToGenerate.size(); i++) {
-        string replaced = replaceVariables(regexToGenerate[i].second, varCharMap);
-        // 去除空格
-        replaced.erase(remove(replaced.begin(), replaced.end(), ' '), replaced.end());
-        regexToGenerate[i].second = replaced;
-        qDebug() << "替换后: " << QString::fromStdString(regexToGenerate[i].first)
-                 << " = " << QString::fromStdString(replaced);
-
-        if (i > 0) combinedRegex += "|";
-        combinedRegex += "(" + QString::fromStdString(replaced) + ")";
+    const char* data() const
+    {
+        return bytes ? (const char*)bytes : "";
     }
 
-    // 处理转义字符
-    for (const auto& pair : m2) {
-        combinedRegex.replace(QString::fromStdString(pair.first), QString(pair.second));
+    size_t size() const
+    {
+        return length;
     }
 
-    finalRegex = combinedRegex.toStdString();
-    qDebug() << "合并后的正则表达式：" << combinedRegex;
-
-    finalRegex = afterHandleRegex(combinedRegex).toStdString();
-    qDebug() << "处理后的正则表达式：" << QString::fromStdString(finalRegex);
-
-    return "";
-}
-
-/*============================正则表达式转NFA==================================*/
-
-struct nfaNode; // 声明一下，不然报错
-
-/*
-* @brief 结构体，NFA图的边
-*/
-struct nfaEdge
-{
-    char c;
-    nfaNode* next;
-};
-/*
-* @brief 结构体，NFA图的结点
-*/
-struct nfaNode
-{
-    int id; // 结点唯一编号
-    bool isStart;   // 初态标识
-    bool isEnd; // 终态标识
-    vector<nfaEdge> edges;  // 边，用vector因为有可能一个结点有多条边可走
-    nfaNode() {
-        id = nodeCount++;
-        isStart = false;
-        isEnd = false;
-    }
+private:
+    QFile file;
+    uchar* bytes;
+    size_t length;
 };
 
-/*
-* @brief 结构体，NFA图
-*/
-struct NFA
+// 源文件对应的结果文件，放在源文件旁边，默认为二进制的 .lexb，textMode 为true时为文本的 .lex
+QString lexOutputPath(const QString& srcFile, bool textMode)
 {
-    nfaNode* start;
-    nfaNode* end;
-    NFA() {}
-    NFA(nfaNode* s, nfaNode* e)
-    {
-        start = s;
-        end = e;
-    }
-};
-
-/*
-* @brief 创建基本字符NFA
-* 只包含一个字符的NFA图
-*/
-NFA CreateBasicNFA(char character) {
-    nfaNode* start = new nfaNode();
-    nfaNode* end = new nfaNode();
-
-    start->isStart = true;
-    end->isEnd = true;
-
-    nfaEdge edge;
-    edge.c = character;
-    edge.next = end;
-    start->edges.push_back(edge);
-
-    NFA nfa(start, end);
-
-    // 存入全局nfa字符set
-    nfaCharSet.insert(character);
-    // 存入全局dfa字符set
-    dfaCharSet.insert(character);
-
-    return nfa;
-}
-
-/*
-* @brief 创建连接运算符的NFA图
-*/
-NFA CreateConcatenationNFA(NFA nfa1, NFA nfa2) {
-    // 把nfa1的终止状态与nfa2的起始状态连接起来
-    nfa1.end->isEnd = false;
-    nfa2.start->isStart = false;
-
-    nfaEdge edge;
-    edge.c = EPSILON; // 这里用EPSILON表示空边
-    edge.next = nfa2.start;
-    nfa1.end->edges.push_back(edge);
-
-    NFA nfa;
-    nfa.start = nfa1.start;
-    nfa.end = nfa2.end;
-
-    return nfa;
-}
-
-/*
-* @brief 创建选择运算符的NFA图
-*/
-NFA CreateUnionNFA(NFA nfa1, NFA nfa2) {
-    nfaNode* start = new nfaNode();
-    nfaNode* end = new nfaNode();
-
-    start->isStart = true;
-    end->isEnd = true;
-
-    // 把新的初态与nfa1和nfa2的初态连接起来
-    nfaEdge edge1;
-    edge1.c = EPSILON;
-    edge1.next = nfa1.start;
-    start->edges.push_back(edge1);
-    nfa1.start->isStart = false;    // 初态结束
-
-    nfaEdge edge2;
-    edge2.c = EPSILON;
-    edge2.next = nfa2.start;
-    start->edges.push_back(edge2);
-    nfa2.start->isStart = false;    // 初态结束
-
-    // 把nfa1和nfa2的终止状态与新的终止状态连接起来
-    nfa1.end->isEnd = false;
-    nfa2.end->isEnd = false;
-
-    nfaEdge edge3;
-    edge3.c = EPSILON;
-    edge3.next = end;
-    nfa1.end->edges.push_back(edge3);
-
-    nfaEdge edge4;
-    edge4.c = EPSILON;
-    edge4.next = end;
-    nfa2.end->edges.push_back(edge4);
-
-    NFA nfa{ start , end };
-
-    return nfa;
-}
-
-/*
-* @brief 创建*运算符的NFA图
-*/
-NFA CreateZeroOrMoreNFA(NFA nfa1) {
-    nfaNode* start = new nfaNode();
-    nfaNode* end = new nfaNode();
-
-    start->isStart = true;
-    end->isEnd = true;
-
-    // 把新的初态与nfa1的初态连接起来
-    nfaEdge edge1;
-    edge1.c = EPSILON;
-    edge1.next = nfa1.start;
-    start->edges.push_back(edge1);
-    nfa1.start->isStart = false;    // 初态结束
-
-    // 把新的初态与新的终止状态连接起来
-    nfaEdge edge2;
-    edge2.c = EPSILON;
-    edge2.next = end;
-    start->edges.push_back(edge2);
-
-    // 把nfa1的终止状态与新的终止状态连接起来
-    nfa1.end->isEnd = false;
-
-    nfaEdge edge3;
-    edge3.c = EPSILON;
-    edge3.next = nfa1.start;
-    nfa1.end->edges.push_back(edge3);
-
-    nfaEdge edge4;
-    edge4.c = EPSILON;
-    edge4.next = end;
-    nfa1.end->edges.push_back(edge4);
-
-    NFA nfa{ start,end };
-
-    return nfa;
-}
-
-/*
-* @brief 创建？运算符的NFA图
-*/
-NFA CreateOptionalNFA(NFA nfa1) {
-    nfaNode* start = new nfaNode();
-    nfaNode* end = new nfaNode();
-
-    start->isStart = true;
-    end->isEnd = true;
-
-    // 把新的初态与nfa1的初态连接起来
-    nfaEdge edge1;
-    edge1.c = EPSILON;
-    edge1.next = nfa1.start;
-    start->edges.push_back(edge1);
-    nfa1.start->isStart = false;    // 初态结束
-
-    // 把新的初态与新的终止状态连接起来
-    nfaEdge edge2;
-    edge2.c = EPSILON;
-    edge2.next = end;
-    start->edges.push_back(edge2);
-
-    // 把nfa1的终止状态与新的终止状态连接起来
-    nfa1.end->isEnd = false;
-
-    nfaEdge edge3;
-    edge3.c = EPSILON;
-    edge3.next = end;
-    nfa1.end->edges.push_back(edge3);
-
-    NFA nfa(start, end);
-
-    return nfa;
-}
-
-/*
-* @brief 判断优先级
-*/
-int Precedence(char op) {
-    if (op == '|') {
-        return 1;  // 选择运算符 "|" 的优先级
-    }
-    else if (op == '@') {
-        return 2;  // 连接运算符 "@" 的优先级
-    }
-    else if (op == '*' || op == '?') {
-        return 3;  // 闭包运算符 "*"和 "?" 的优先级
-    }
-    else {
-        return 0;  // 默认情况下，将其它字符的优先级设为0
+    QString ext = textMode ? ".lex" : ".lexb";
+    QString outputLexPath = srcFile;
+    if (outputLexPath.endsWith(".tny", Qt::CaseInsensitive) ||
+        outputLexPath.endsWith(".mc", Qt::CaseInsensitive) ||
+        outputLexPath.endsWith(".c", Qt::CaseInsensitive)) {
+        int dotPos = outputLexPath.lastIndexOf('.');
+        outputLexPath = outputLexPath.left(dotPos) + ext;
+    } else {
+        outputLexPath += ext;
     }
+    return outputLexPath;
 }
 
 /*
-* @brief 结构体，状态转换表单个结点
+* @brief 写入词法分析结果文件
+* 默认写二进制单词文件，textMode 为true时写文本（text 为文本格式的结果），失败时返回错误信息
 */
-struct statusTableNode
-{
-    string flag;  // 标记初态还是终态
-    int id; // 唯一id值
-    map<char, set<int>> m;  // 对应字符能到达的状态
-    statusTableNode()
-    {
-        flag = ""; // 默认为空
-    }
-};
-
-// 状态转换表
-unordered_map<int, statusTableNode> statusTable;
-// statusTable插入顺序记录，方便后续输出
-vector<int> insertionOrder;
-set<int> startNFAstatus;
-set<int> endNFAstatus;
-
-/*
-* @brief 生成状态转换表
-* 使用DFS算法
-*/
-void createNFAStatusTable(NFA& nfa)
-{
-    stack<nfaNode*> nfaStack;
-    set<nfaNode*> visitedNodes;
-
-    // 初态
-    nfaNode* startNode = nfa.start;
-    statusTableNode startStatusNode;
-    startStatusNode.flag = '-'; // -表示初态
-    startStatusNode.id = startNode->id;
-    statusTable[startNode->id] = startStatusNode;
-    insertionOrder.push_back(startNode->id);
-    startNFAstatus.insert(startNode->id);
-
-    nfaStack.push(startNode);
-
-    while (!nfaStack.empty()) {
-        nfaNode* currentNode = nfaStack.top();
-        nfaStack.pop();
-        visitedNodes.insert(currentNode);
-
-        for (nfaEdge edge : currentNode->edges) {
-            char transitionChar = edge.c;
-            nfaNode* nextNode = edge.next;
-
-            // 记录状态转换信息
-            statusTable[currentNode->id].m[transitionChar].insert(nextNode->id);
-
-            // 如果下一个状态未被访问，将其加入堆栈
-            if (visitedNodes.find(nextNode) == visitedNodes.end()) {
-                nfaStack.push(nextNode);
-
-                // 记录状态信息
-                statusTableNode nextStatus;
-                nextStatus.id = nextNode->id;
-                if (nextNode->isStart) {
-                    nextStatus.flag += '-'; // -表示初态
-                    startNFAstatus.insert(nextStatus.id);
-                }
-                else if (nextNode->isEnd) {
-                    nextStatus.flag += '+'; // +表示终态
-                    endNFAstatus.insert(nextStatus.id);
-                }
-                statusTable[nextNode->id] = nextStatus;
-                // 记录插入顺序（排除终态）
-                if (!nextNode->isEnd)
-                {
-                    insertionOrder.push_back(nextNode->id);
-                }
-            }
-        }
-    }
-
-    // 顺序表才插入终态
-    nfaNode* endNode = nfa.end;
-    insertionOrder.push_back(endNode->id);
-}
-
-// 测试输出NFA状态转换表程序（debug使用）
-void printStatusTable() {
-    // 打印状态表按照插入顺序
-    for (int id : insertionOrder) {
-        const statusTableNode& node = statusTable[id];
-        qDebug() << "Node ID: " << node.id << ", Flag: " << QString::fromStdString(node.flag) << "\n";
-
-        for (const auto& entry : node.m) {
-            char transitionChar = entry.first;
-            const std::set<int>& targetStates = entry.second;
-
-            qDebug() << "  Transition: " << transitionChar << " -> {";
-            for (int targetState : targetStates) {
-                qDebug() << targetState << " ";
-            }
-            qDebug() << "}\n";
-        }
-    }
+string saveLexResult(const LexerCompilation& lc, const QString& outputPath, bool textMode, const string& text,
+                     const vector<ScanToken>& tokens, const MappedSource& source, const LexLangProfile& profile)
+{
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if (textMode) mode |= QIODevice::Text;
+    QFile lexFile(outputPath);
+    if (!lexFile.open(mode)) {
+        return "无法写入 " + outputPath.toStdString();
+    }
+    string data = textMode ? text : lc.lexBinary(tokens, source.data(), source.size(), profile);
+    lexFile.write(data.c_str(), data.size());
+    lexFile.close();
+    return "";
 }
 
-
-/*
-* @brief 正则表达式转NFA入口
-*/
-NFA regex2NFA(string regex)
+// 缓存文件路径，缓存目录不存在时创建
+QString automatonCachePath(uint64_t key)
 {
-    // 双栈法，创建两个栈opStack（运算符栈）,nfaStack（nfa图栈）
-    stack<char> opStack;
-    stack<NFA> nfaStack;
-
-    // 对表达式进行类似于逆波兰表达式处理
-    // 运算符：| @（） ？ +  *
-    for (char c : regex)
-    {
-        switch (c)
-        {
-        case ' ': // 空格跳过
-            break;
-        case '(':
-            opStack.push(c);
-            break;
-        case ')':
-            while (!opStack.empty() && opStack.top() != '(')
-            {
-                // 处理栈顶运算符，构建NFA图，并将结果入栈
-                char op = opStack.top();
-                opStack.pop();
-
-                if (op == '|') {
-                    // 处理并构建"|"运算符
-                    NFA nfa2 = nfaStack.top();
-                    nfaStack.pop();
-                    NFA nfa1 = nfaStack.top();
-                    nfaStack.pop();
-
-                    // 创建新的NFA，表示nfa1 | nfa2
-                    NFA resultNFA = CreateUnionNFA(nfa1, nfa2);
-                    nfaStack.push(resultNFA);
-                }
-                else if (op == '@') {
-                    // 处理并构建"."运算符
-                    NFA nfa2 = nfaStack.top();
-                    nfaStack.pop();
-                    NFA nfa1 = nfaStack.top();
-                    nfaStack.pop();
-
-                    // 创建新的NFA，表示nfa1 . nfa2
-                    NFA resultNFA = CreateConcatenationNFA(nfa1, nfa2);
-                    nfaStack.push(resultNFA);
-                }
-            }
-            if (opStack.empty())
-            {
-                qDebug() << "括号未闭合，请检查正则表达式！";
-                exit(-1);
-            }
-            else
-            {
-                opStack.pop(); // 弹出(
-            }
-            break;
-        case '|':
-        case '@':
-            // 处理运算符 | 和 @
-            while (!opStack.empty() && (opStack.top() == '|' || opStack.top() == '@') &&
-                   Precedence(opStack.top()) >= Precedence(c))
-            {
-                char op = opStack.top();
-                opStack.pop();
-
-                // 处理栈顶运算符，构建NFA图，并将结果入栈
-                if (op == '|') {
-                    // 处理并构建"|"运算符
-                    NFA nfa2 = nfaStack.top();
-                    nfaStack.pop();
-                    NFA nfa1 = nfaStack.top();
-                    nfaStack.pop();
-
-                    // 创建新的NFA，表示nfa1 | nfa2
-                    NFA resultNFA = CreateUnionNFA(nfa1, nfa2);
-                    nfaStack.push(resultNFA);
-                }
-                else if (op == '@') {
-                    // 处理并构建"."运算符
-                    NFA nfa2 = nfaStack.top();
-                    nfaStack.pop();
-                    NFA nfa1 = nfaStack.top();
-                    nfaStack.pop();
-
-                    // 创建新的 NFA，表示 nfa1 . nfa2
-                    NFA resultNFA = CreateConcatenationNFA(nfa1, nfa2);
-                    nfaStack.push(resultNFA);
-                }
-            }
-            opStack.push(c);
-            break;
-        case '?':
-        case '*':
-            // 处理闭包运算符 ? + *
-            // 从nfaStack弹出NFA，应用相应的闭包操作，并将结果入栈
-            if (!nfaStack.empty()) {
-                NFA nfa = nfaStack.top();
-                nfaStack.pop();
-                if (c == '?') {
-                    // 处理 ?
-                    NFA resultNFA = CreateOptionalNFA(nfa);
-                    nfaStack.push(resultNFA);
-                }
-                else if (c == '*') {
-                    // 处理 *
-                    NFA resultNFA = CreateZeroOrMoreNFA(nfa);
-                    nfaStack.push(resultNFA);
-                }
-            }
-            else {
-                qDebug() << "正则表达式语法错误：闭包操作没有NFA可用！";
-                exit(-1);
-            }
-            break;
-        default:
-            // 处理字母字符
-            NFA nfa = CreateBasicNFA(c); // 创建基本的字符NFA
-            nfaStack.push(nfa);
-            break;
-        }
-
-    }
-
-    // 处理栈中剩余的运算符
-    while (!opStack.empty())
-    {
-        char op = opStack.top();
-        opStack.pop();
-
-        if (op == '|' || op == '@')
-        {
-            // 处理并构建运算符 | 和 .
-            if (nfaStack.size() < 2)
-            {
-                qDebug() << "正则表达式语法错误：不足以处理运算符 " << op << "！";
-                exit(-1);
-            }
-
-            NFA nfa2 = nfaStack.top();
-            nfaStack.pop();
-            NFA nfa1 = nfaStack.top();
-            nfaStack.pop();
-
-            if (op == '|')
-            {
-                // 创建新的 NFA，表示 nfa1 | nfa2
-                NFA resultNFA = CreateUnionNFA(nfa1, nfa2);
-                nfaStack.push(resultNFA);
-            }
-            else if (op == '@')
-            {
-                // 创建新的 NFA，表示 nfa1 . nfa2
-                NFA resultNFA = CreateConcatenationNFA(nfa1, nfa2);
-                nfaStack.push(resultNFA);
-            }
-        }
-        else
-        {
-            qDebug() << "正则表达式语法错误：未知的运算符 " << op << "！";
-            exit(-1);
-        }
-    }
-
-    // 最终的NFA图在nfaStack的顶部
-    NFA result = nfaStack.top();
-    qDebug() << "NFA图构建完毕";
-
-    createNFAStatusTable(result);
-    qDebug() << "状态转换表构建完毕";
-
-    return result;
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/automata";
+    QDir().mkpath(dir);
+    return dir + "/" + QString::number((qulonglong)key, 16) + ".r2la";
 }
 
-/*============================NFA转DFA==================================*/
-//map<int, nfaNode> nfaStates;
-
-// dfa节点
-struct dfaNode
+// 把分析得到的表（包括字节等价类）写入缓存文件，写完整后才替换旧文件
+string saveAutomatonCache(LexerCompilation& lc, const QString& path, const string& spec)
 {
-    string flag; // 是否包含终态（+）或初态（-）
-    set<int> nfaStates; // 该DFA状态包含的NFA状态的集合
-    map<char, set<int>> transitions; // 字符到下一状态的映射
-    dfaNode() {
-        flag = "";
+    string data = lc.saveAutomaton(spec);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return "无法写入自动机缓存 " + path.toStdString();
     }
-};
-// dfa状态去重集
-set<set<int>> dfaStatusSet;
-
-// dfa最终结果
-vector<dfaNode> dfaTable;
-
-//下面用于DFA最小化
-// dfa终态集合
-set<int> dfaEndStatusSet;
-// dfa非终态集合
-set<int> dfaNotEndStatusSet;
-// set对应序号MAP
-map<set<int>, int> dfa2numberMap;
-int startStaus;
-
-// 判断是否含有初态终态，含有则返回对应字符串
-string setHasStartOrEnd(set<int>& statusSet)
-{
-    string result = "";
-    for (const int& element : startNFAstatus) {
-        if (statusSet.count(element) > 0) {
-            result += "-";
-        }
-    }
-
-    for (const int& element : endNFAstatus) {
-        if (statusSet.count(element) > 0) {
-            result += "+";
-        }
+    file.write(data.data(), data.size());
+    if (!file.commit()) {
+        return "无法写入自动机缓存 " + path.toStdString();
     }
-
-    return result;
+    return "";
 }
 
-set<int> epsilonClosure(int id)
+// 从缓存文件读入全部表，返回错误信息，空串表示成功
+string loadAutomatonCache(LexerCompilation& lc, const QString& path, const string& spec)
 {
-    set<int> eResult{ id };
-    stack<int> stack;
-    stack.push(id);
-
-    while (!stack.empty())
-    {
-        int current = stack.top();
-        stack.pop();
-
-        set<int> eClosure = statusTable[current].m[EPSILON];
-        for (auto t : eClosure)
-        {
-            if (eResult.find(t) == eResult.end())
-            {
-                eResult.insert(t);
-                stack.push(t);
-            }
-        }
+    if (!QFile::exists(path)) {
+        return "没有缓存";
     }
-
-    return eResult;
-}
-
-set<int> otherCharClosure(int id, char ch)
-{
-    set<int> otherResult{};
-    set<int> processed;
-    stack<int> stack;
-    stack.push(id);
-
-    while (!stack.empty())
-    {
-        int current = stack.top();
-        stack.pop();
-
-        if (processed.find(current) != processed.end())
-            continue;
-
-        processed.insert(current);
-
-        set<int> otherClosure = statusTable[current].m[ch];
-        for (auto o : otherClosure)
-        {
-            auto tmp = epsilonClosure(o);
-            otherResult.insert(tmp.begin(), tmp.end());
-            stack.push(o);
-        }
+    MappedSource file(path);
+    string error = file.open();
+    if (!error.empty()) {
+        return error;
     }
-
-    return otherResult;
+    return lc.loadAutomaton(file.data(), file.size(), spec);
 }
 
+/*============================后台分析==================================*/
 
-
-// DFA debug输出函数
-void printDfaTable(const vector<dfaNode>& dfaTable) {
-    for (size_t i = 0; i < dfaTable.size(); ++i) {
-        qDebug() << "DFA Node " << i << " - Flag: " << QString::fromStdString(dfaTable[i].flag);
-        qDebug() << "NFA States: ";
-        for (const int state : dfaTable[i].nfaStates) {
-            qDebug() << state;
-        }
-        qDebug() << "Transitions: ";
-        for (const auto& transition : dfaTable[i].transitions) {
-            qDebug() << "  Input: " << transition.first;
-            qDebug() << "  Next States: ";
-            for (const int nextState : transition.second) {
-                qDebug() << nextState;
-            }
-        }
-        qDebug() << "---------------------";
+/*
+* @brief 在后台线程中由规则构造自动机
+* 每次分析都用一个新的 LexerCompilation，界面正在显示的上一次结果不受影响。
+* perRule 为真时按规则构造DFA，ruleCache 中保留各规则的DFA，供下一次分析使用
+*/
+AnalysisResult analyzeRules(const string& allRegex, bool lowerCase, NFAConstruction construction,
+                            bool perRule, RuleDFACache* ruleCache)
+{
+    AnalysisResult result;
+    LexerCompilation* lc = new LexerCompilation;
+    lc->isLowerCase = lowerCase;
+    lc->nfaConstruction = construction;
+
+    // 规则和选项没变时直接读入上次构造的自动机
+    string cacheSpec = automatonCacheSpec(allRegex, lowerCase, construction, perRule);
+    QString cachePath = automatonCachePath(automatonCacheKey(cacheSpec));
+    QElapsedTimer timer;
+    timer.start();
+    string cacheError = loadAutomatonCache(*lc, cachePath, cacheSpec);
+    if (cacheError.empty()) {
+        result.report = QString("从缓存读入自动机，用时 %1 ms\n").arg(timer.elapsed())
+                      + QString("NFA：%1 个状态，DFA：%2 个状态，最小化DFA：%3 个状态")
+                            .arg(lc->nfaArena.stateCount).arg((int)lc->dfaTable.size()).arg((int)lc->dfaMinTable.size());
+        result.compilation = lc;
+        return result;
     }
-}
+    qDebug() << "没有使用自动机缓存：" << QString::fromStdString(cacheError);
+    lc->init();
 
-void NFA2DFA(NFA& nfa)
-{
-    int dfaStatusCount = 1;
-    auto start = nfa.start; // 获得NFA图的起始位置
-    auto startId = start->id;   // 获得起始编号
-    dfaNode startDFANode;
-    startDFANode.nfaStates = epsilonClosure(startId); // 初始闭包
-    startDFANode.flag = setHasStartOrEnd(startDFANode.nfaStates); // 判断初态终态
-    deque<set<int>> newStatus{};
-    dfa2numberMap[startDFANode.nfaStates] = dfaStatusCount;
-    startStaus = dfaStatusCount;
-    if (setHasStartOrEnd(startDFANode.nfaStates).find("+") != string::npos) {
-        dfaEndStatusSet.insert(dfaStatusCount++);
-    }
-    else
-    {
-        dfaNotEndStatusSet.insert(dfaStatusCount++);
+    result.error = lc->handleAllRegex(allRegex, lowerCase);
+    // 如果字符串不为空就是报错了，退出
+    if (!result.error.empty()) {
+        delete lc;
+        return result;
     }
-    // 对每个字符进行遍历
-    for (auto ch : dfaCharSet)
-    {
-        set<int> thisChClosure{};
-        for (auto c : startDFANode.nfaStates)
-        {
-            set<int> tmp = otherCharClosure(c, ch);
-            thisChClosure.insert(tmp.begin(), tmp.end());
-        }
-        if (thisChClosure.empty())  // 如果这个闭包是空集没必要继续下去了
-        {
-            continue;
-        }
-        int presize = dfaStatusSet.size();
-        dfaStatusSet.insert(thisChClosure);
-        int lastsize = dfaStatusSet.size();
-        // 不管一不一样都是该节点这个字符的状态
-        startDFANode.transitions[ch] = thisChClosure;
-        // 如果大小不一样，证明是新状态
-        if (lastsize > presize)
-        {
-            dfa2numberMap[thisChClosure] = dfaStatusCount;
-            newStatus.push_back(thisChClosure);
-            if (setHasStartOrEnd(thisChClosure).find("+") != string::npos) {
-                dfaEndStatusSet.insert(dfaStatusCount++);
-            }
-            else
-            {
-                dfaNotEndStatusSet.insert(dfaStatusCount++);
-            }
-
-        }
 
+    //正则表达式转换成NFA图
+    timer.restart();
+    NFA nfa = lc->regex2NFA();
+    qint64 nfaTime = timer.restart();
+
+    // 重叠的输入符号划分为字节原子
+    lc->splitSymbolAtoms();
+
+    // NFA转DFA，状态太多时不再构造完整的DFA，NFA仍可用于直接分析
+    result.compilation = lc;
+    bool complete = perRule ? lc->rules2DFA(ruleCache, eagerDFAStateLimit)
+                            : lc->NFA2DFA(nfa, eagerDFAStateLimit);
+    if (!complete) {
+        result.tooManyStates = true;
+        return result;
     }
-    dfaTable.push_back(startDFANode);
+    qint64 dfaTime = timer.restart();
 
-    // 对后面的新状态进行不停遍历
-    while (!newStatus.empty())
-    {
-        // 拿出一个新状态
-        set<int> ns = newStatus.front();
-        newStatus.pop_front();
-        dfaNode DFANode;
-        DFANode.nfaStates = ns;  // 该节点状态集合
-        DFANode.flag = setHasStartOrEnd(ns);
-
-        for (auto ch : dfaCharSet)
-        {
-
-            set<int> thisChClosure{};
-            for (auto c : ns)
-            {
-                set<int> tmp = otherCharClosure(c, ch);
-                thisChClosure.insert(tmp.begin(), tmp.end());
-            }
-            if (thisChClosure.empty())  // 如果这个闭包是空集没必要继续下去了
-            {
-                continue;
-            }
-            int presize = dfaStatusSet.size();
-            dfaStatusSet.insert(thisChClosure);
-            int lastsize = dfaStatusSet.size();
-            // 不管一不一样都是该节点这个字符的状态
-            DFANode.transitions[ch] = thisChClosure;
-            // 如果大小不一样，证明是新状态
-            if (lastsize > presize)
-            {
-                dfa2numberMap[thisChClosure] = dfaStatusCount;
-                newStatus.push_back(thisChClosure);
-                if (setHasStartOrEnd(thisChClosure).find("+") != string::npos) {
-                    dfaEndStatusSet.insert(dfaStatusCount++);
-                }
-                else
-                {
-                    dfaNotEndStatusSet.insert(dfaStatusCount++);
-                }
-
-            }
+    lc->DFAminimize();
+    qint64 minTime = timer.restart();
 
-        }
-        dfaTable.push_back(DFANode);
+    // 字节等价类压缩
+    lc->DFAbyteClasses();
 
+    string saveError = saveAutomatonCache(*lc, cachePath, cacheSpec);
+    if (!saveError.empty()) {
+        qDebug() << QString::fromStdString(saveError);
     }
 
-    // dfa debug
-    // printDfaTable(dfaTable);
+    QString dfaReport = perRule ? QString("DFA：%1 个状态，按规则构造用时 %2 ms（重新构造 %3 条规则，复用 %4 条）\n")
+                                      .arg((int)lc->dfaTable.size()).arg(dfaTime)
+                                      .arg(lc->ruleDFAsBuilt).arg(lc->ruleDFAsReused)
+                                : QString("DFA：%1 个状态，子集构造用时 %2 ms\n").arg((int)lc->dfaTable.size()).arg(dfaTime);
+    result.report = QString("NFA（%1构造）：%2 个状态，%3 条边，用时 %4 ms\n")
+                        .arg(construction == NFA_GLUSHKOV ? "Glushkov" : "Thompson")
+                        .arg(lc->nfaArena.stateCount).arg((int)lc->nfaArena.edgeNext.size()).arg(nfaTime)
+                  + dfaReport
+                  + QString("最小化DFA：%1 个状态，用时 %2 ms").arg((int)lc->dfaMinTable.size()).arg(minTime);
+    return result;
 }
 
-/*============================DFA最小化==================================*/
 /*
-// dfa终态集合
-set<int> dfaEndStatusSet;
-// dfa非终态集合
-set<int> dfaNotEndStatusSet;
-// set对应序号MAP
-map<set<int>, int> dfa2numberMap;
+* @brief 开始分析按钮
+* 分析在后台线程中进行，期间可以继续查看上一次的结果，只是不能再次开始分析
 */
+void Widget::on_pushButton_clicked(){
+    // 拿到所有的正则表达式
+    string allRegex = ui->plainTextEdit_2->toPlainText().toStdString();
 
-// 判断是否含有初态终态，含有则返回对应字符串
-string minSetHasStartOrEnd(set<int>& statusSet)
-{
-    string result = "";
-    if (statusSet.count(startStaus) > 0) {
-        result += "-";
-    }
-
-    for (const int& element : dfaEndStatusSet) {
-        if (statusSet.count(element) > 0) {
-            result += "+";
-            break;  // 可能会有多个终态同时包含，我们只要一个
-        }
-    }
-
-    return result;
-}
-
-// dfa最小化节点
-struct dfaMinNode
-{
-    string flag; // 是否包含终态（+）或初态（-）
-    int id;
-    map<char, int> transitions; // 字符到下一状态的映射
-    dfaMinNode() {
-        flag = "";
-    }
-};
-
-vector<dfaMinNode> dfaMinTable;
-
-// 用于分割集合
-vector<set<int>> divideVector;
-// 存下标
-map<int, int> dfaMinMap;
-
-
-// 根据字符 ch 将状态集合 node 分成两个子集合
-void splitSet(int i, char ch)
-{
-    set<int> result;
-    auto& node = divideVector[i];
-    int s = -2;
-
-    for (auto state : node)
-    {
-        int thisNum;
-        if (dfaTable[state - 1].transitions.find(ch) == dfaTable[state - 1].transitions.end())
-        {
-            thisNum = -1; // 空集
-        }
-        else
-        {
-            // 根据字符 ch 找到下一个状态
-            int next_state = dfa2numberMap[dfaTable[state - 1].transitions[ch]];
-            thisNum = dfaMinMap[next_state];    // 这个状态的下标是多少
-        }
-
-        if (s == -2)    // 初始下标
-        {
-            s = thisNum;
-        }
-        else if (thisNum != s)   // 如果下标不同，就是有问题，需要分出来
-        {
-            result.insert(state);
-        }
-    }
-
-    // 删除要删除的元素
-    for (int state : result) {
-        node.erase(state);
-    }
-
-    // 都遍历完了，如果result不是空，证明有新的，加入vector中
-    if (!result.empty())
-    {
-        divideVector.push_back(result);
-        // 同时更新下标
-        for (auto a : result)
-        {
-            dfaMinMap[a] = divideVector.size() - 1;
-        }
-    }
+    bool lowerCase = ui->checkBox->isChecked();
+    qDebug() <<"是否区分大小写："<< lowerCase;
+    NFAConstruction construction = (ui->comboBox_nfa->currentIndex() == 1) ? NFA_GLUSHKOV : NFA_THOMPSON;
+    bool perRule = ui->checkBox_perRule->isChecked();
 
+    ui->pushButton->setEnabled(false);
+    ui->pushButton->setText("分析中...");
+    m_analysis->setFuture(QtConcurrent::run(analyzeRules, allRegex, lowerCase, construction, perRule, m_ruleCache));
 }
 
-void DFAminimize()
+/*
+* @brief 后台分析结束
+* 规则有错时保留上一次的结果，否则换成新的编译结果
+*/
+void Widget::analysisFinished()
 {
-    divideVector.clear();
-    dfaMinMap.clear();
-
-    // 存入非终态、终态集合
-    if (dfaNotEndStatusSet.size() != 0)
-    {
-        divideVector.push_back(dfaNotEndStatusSet);
-    }
-    // 初始化map
-    for (auto t : dfaNotEndStatusSet)
-    {
-        dfaMinMap[t] = divideVector.size() - 1;
-    }
-
-    divideVector.push_back(dfaEndStatusSet);
-
-    for (auto t : dfaEndStatusSet)
-    {
-        dfaMinMap[t] = divideVector.size() - 1;
-    }
-
-    // 当flag为1时，一直循环
-    int continueFlag = 1;
+    AnalysisResult result = m_analysis->result();
+    ui->pushButton->setEnabled(true);
+    ui->pushButton->setText("开始分析");
 
-    while (continueFlag)
-    {
-        continueFlag = 0;
-        int size1 = divideVector.size();
-
-        for (int i = 0; i < size1; i++)
-        {
-
-            // 逐个字符尝试分割状态集合
-            for (char ch : dfaCharSet)
-            {
-                splitSet(i, ch);
-            }
-        }
-        int size2 = divideVector.size();
-        if (size2 > size1)
-        {
-            continueFlag = 1;
-        }
-    }
-
-    for (int dfaMinCount = 0; dfaMinCount < divideVector.size(); dfaMinCount++)
-    {
-        auto& v = divideVector[dfaMinCount];
-        dfaMinNode d;
-        d.flag = minSetHasStartOrEnd(v);
-        d.id = dfaMinCount;
-        // 逐个字符
-        for (char ch : dfaCharSet)
-        {
-            if (v.size() == 0)
-            {
-                d.transitions[ch] = -1;   // 空集特殊判断
-                continue;
-            }
-            int i = *(v.begin()); // 拿一个出来
-            if (dfaTable[i - 1].transitions.find(ch) == dfaTable[i - 1].transitions.end())
-            {
-                d.transitions[ch] = -1;   // 空集特殊判断
-                continue;
-            }
-            int next_state = dfa2numberMap[dfaTable[i - 1].transitions[ch]];
-            int thisNum = dfaMinMap[next_state];    // 这个状态下标
-            d.transitions[ch] = thisNum;
-        }
-        dfaMinTable.push_back(d);
+    if (!result.error.empty()) {
+        QMessageBox::critical(this, "错误信息", QString::fromStdString(result.error));
+        return;
     }
+    delete m_comp;
+    m_comp = result.compilation;
 
-    // 输出 dfaMinTable
-    for (const dfaMinNode& node : dfaMinTable) {
-        qDebug() << "State " << node.id << ":";
-        qDebug() << "Flag: " << QString::fromStdString(node.flag);
-
-        for (const auto& entry : node.transitions) {
-            qDebug() << entry.first << " -> " << entry.second;
-        }
+    if (result.tooManyStates) {
+        QMessageBox::warning(this, "提示", QString("DFA状态数超过 %1，没有构造完整的DFA，无法查看DFA和生成代码。\n"
+                                                   "可以点击\"直接分析\"，用按需构造的DFA分析源文件。").arg(eagerDFAStateLimit));
+        return;
     }
+    qDebug() << result.report;
 
-    qDebug() << "DFA最小化完成！";
-}
-
-// 辅助函数：根据变量定义生成字符范围的 case 语句
-void generateCasesForVarDef(const string& varDef, QString& codeStr, bool& isLetter, bool& isDigit)
-{
-    // 解析变量定义，如 [A-Za-z] 或 [0-9]
-    if (varDef.empty()) return;
-
-    size_t i = 0;
-    while (i < varDef.size()) {
-        if (varDef[i] == '[') {
-            i++;
-            continue;
-        }
-        if (varDef[i] == ']') {
-            break;
-        }
+    // 源程序编辑框改用新的DFA分析
+    resetLiveLexer();
 
-        // 检查是否是范围，如 A-Z
-        if (i + 2 < varDef.size() && varDef[i + 1] == '-') {
-            char start = varDef[i];
-            char end = varDef[i + 2];
-            for (char c = start; c <= end; c++) {
-                codeStr += "\t\t\tcase \'" + QString(c) + "\':\n";
-                if (isalpha(c)) isLetter = true;
-                if (isdigit(c)) isDigit = true;
-            }
-            i += 3;
-        } else {
-            // 单个字符
-            char c = varDef[i];
-            if (c != '[' && c != ']') {
-                codeStr += "\t\t\tcase \'" + QString(c) + "\':\n";
-                if (isalpha(c)) isLetter = true;
-                if (isdigit(c)) isDigit = true;
-            }
-            i++;
-        }
-    }
+    QMessageBox::about(this, "提示", "分析成功！请点击其余按钮查看结果！\n\n" + result.report);
 }
 
-bool genLexCase(QList<QString> tmpList, QString& codeStr, int idx, bool flag)
-{
-    bool rFlag = false;
-    for (int i = 0; i < tmpList.size(); i++)
-    {
-        QString tmpKey = tmpList[i];
-        char ch = tmpKey.toUtf8().constData()[0];
-        if (dfaMinTable[idx].transitions[ch] == -1) {
-            continue;
-        }
-
-        bool isLetter = false;
-        bool isDigit = false;
-
-        // 检查是否是变量（动态映射的特殊字符）
-        if (charVarMap.find(ch) != charVarMap.end()) {
-            string varName = charVarMap[ch];
-            if (varDefMap.find(varName) != varDefMap.end()) {
-                string varDef = varDefMap[varName];
-                generateCasesForVarDef(varDef, codeStr, isLetter, isDigit);
-                codeStr.chop(1); // 去掉最后一个换行
-                if (flag) {
-                    if (isLetter) codeStr += "isIdentifier = true; ";
-                    if (isDigit) codeStr += "isDigit = true; ";
-                    codeStr += "state = " + QString::number(dfaMinTable[idx].transitions[ch]) + "; ";
-                }
-                codeStr += "break;\n";
-                continue;
-            }
-        }
-
-        // 处理转义字符（如 \+ \* 等）
-        if (m1.find(ch) != m1.end()) {
-            string keyRes = m1[ch];
-            // 处理特殊字符的转义
-            if (keyRes == "+") keyRes = "+";
-            else if (keyRes == "*") keyRes = "*";
-            else if (keyRes == "-") keyRes = "-";
-            else if (keyRes == "|") keyRes = "|";
-            else if (keyRes == "(") keyRes = "(";
-            else if (keyRes == ")") keyRes = ")";
-            else if (keyRes == "?") keyRes = "?";
-            else if (keyRes == "[") keyRes = "[";
-            else if (keyRes == "]") keyRes = "]";
-            else if (keyRes == "~") {
-                rFlag = true;
-                continue;
-            }
-            codeStr += "\t\t\tcase \'" + QString::fromStdString(keyRes) + "\':";
-        } else {
-            // 普通字符
-            codeStr += "\t\t\tcase \'" + QString(ch) + "\':";
-        }
-
-        if (flag) {
-            codeStr += "state = " + QString::number(dfaMinTable[idx].transitions[ch]) + "; ";
-        }
-        codeStr += "break;\n";
-    }
-    return rFlag;
-}
-
-QString generateLexer(QString filePath)
+// IncrementalLexer、LexerCompilation 定义之后才能析构 m_liveLexer、m_comp
+Widget::~Widget()
 {
-    QString lexCode;
-
-    // 生成完整的 TINY 语言词法分析器
-    lexCode += R"(#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-#include <ctype.h>
-
-// Token types
-typedef enum {
-    TOKEN_KEYWORD,
-    TOKEN_ID,
-    TOKEN_NUM,
-    TOKEN_OPERATOR,
-    TOKEN_DELIMITER,
-    TOKEN_EOF,
-    TOKEN_ERROR
-} TokenType;
-
-// Keywords (8 total, case-insensitive)
-const char* keywords[] = {"if", "then", "else", "end", "repeat", "until", "read", "write"};
-const int NUM_KEYWORDS = 8;
-
-// Token counter
-int tokenCount = 0;
-
-// Convert string to lowercase
-void toLowerStr(char* str) {
-    for (int i = 0; str[i]; i++) {
-        str[i] = tolower(str[i]);
-    }
-}
-
-// Check if string is a keyword
-bool isKeyword(const char* str) {
-    char lower[256];
-    strcpy(lower, str);
-    toLowerStr(lower);
-    for (int i = 0; i < NUM_KEYWORDS; i++) {
-        if (strcmp(lower, keywords[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Get keyword name (lowercase)
-const char* getKeywordName(const char* str) {
-    static char lower[256];
-    strcpy(lower, str);
-    toLowerStr(lower);
-    return lower;
-}
-
-// Output a token
-void outputToken(FILE* fp, TokenType type, const char* value) {
-    tokenCount++;
-    const char* typeName;
-    switch (type) {
-        case TOKEN_KEYWORD: typeName = "KEYWORD"; break;
-        case TOKEN_ID: typeName = "ID"; break;
-        case TOKEN_NUM: typeName = "NUM"; break;
-        case TOKEN_OPERATOR: typeName = "OPERATOR"; break;
-        case TOKEN_DELIMITER: typeName = "DELIMITER"; break;
-        case TOKEN_EOF: typeName = "EOF"; break;
-        default: typeName = "ERROR"; break;
-    }
-    fprintf(fp, "%d: %s, %s\n", tokenCount, typeName, value);
-    printf("%d: %s, %s\n", tokenCount, typeName, value);
-}
-
-// Lexical analyzer
-void analyze(FILE* input_fp, FILE* output_fp) {
-    int c;
-    char buffer[1024];
-    int bufIdx;
-    
-    printf("\n=== Lexical Analysis Results ===\n\n");
-    fprintf(output_fp, "=== Lexical Analysis Results ===\n\n");
-    
-    while ((c = fgetc(input_fp)) != EOF) {
-        // Skip whitespace
-        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-            continue;
-        }
-        
-        // Handle comments { ... }
-        if (c == '{') {
-            while ((c = fgetc(input_fp)) != EOF && c != '}') {
-                // Skip comment content
-            }
-            continue;
-        }
-        
-        // Handle identifiers and keywords
-        if (isalpha(c)) {
-            bufIdx = 0;
-            buffer[bufIdx++] = c;
-            while ((c = fgetc(input_fp)) != EOF && (isalnum(c))) {
-                buffer[bufIdx++] = c;
-            }
-            buffer[bufIdx] = '\0';
-            if (c != EOF) ungetc(c, input_fp);
-            
-            if (isKeyword(buffer)) {
-                outputToken(output_fp, TOKEN_KEYWORD, getKeywordName(buffer));
-            } else {
-                outputToken(output_fp, TOKEN_ID, buffer);
-            }
-            continue;
-        }
-        
-        // Handle numbers
-        if (isdigit(c)) {
-            bufIdx = 0;
-            buffer[bufIdx++] = c;
-            while ((c = fgetc(input_fp)) != EOF && isdigit(c)) {
-                buffer[bufIdx++] = c;
-            }
-            buffer[bufIdx] = '\0';
-            if (c != EOF) ungetc(c, input_fp);
-            
-            outputToken(output_fp, TOKEN_NUM, buffer);
-            continue;
-        }
-        
-        // Handle operators and delimiters
-        buffer[0] = c;
-        buffer[1] = '\0';
-        
-        // Check for two-character operators
-        int next = fgetc(input_fp);
-        if (c == ':' && next == '=') {
-            strcpy(buffer, ":=");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '<' && next == '=') {
-            strcpy(buffer, "<=");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '>' && next == '=') {
-            strcpy(buffer, ">=");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '<' && next == '>') {
-            strcpy(buffer, "<>");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else {
-            if (next != EOF) ungetc(next, input_fp);
-            
-            // Single character operators
-            if (c == '+' || c == '-' || c == '*' || c == '/' || 
-                c == '%' || c == '^' || c == '<' || c == '>' || c == '=') {
-                outputToken(output_fp, TOKEN_OPERATOR, buffer);
-            }
-            // Delimiters
-            else if (c == ';' || c == '(' || c == ')') {
-                outputToken(output_fp, TOKEN_DELIMITER, buffer);
-            }
-            // Unknown character - skip
-            else {
-                // Ignore unknown characters
-            }
-        }
-    }
-    
-    printf("\nTokens saved to output file\n");
-}
-
-int main(int argc, char* argv[]) {
-)";
-
-    // 修改 main 函数，支持命令行参数
-    lexCode += R"(
-    if (argc < 2) {
-        printf("Usage: %s <input.tny> [output.lex]\n", argv[0]);
-        printf("Example: %s sample.tny\n", argv[0]);
-        printf("         %s sample.tny result.lex\n", argv[0]);
-        return 1;
-    }
-    
-    const char* inputFile = argv[1];
-    
-    // 生成输出文件名：如果提供了第二个参数则使用，否则将 .tny 替换为 .lex
-    char outputFile[1024];
-    if (argc >= 3) {
-        strcpy(outputFile, argv[2]);
-    } else {
-        strcpy(outputFile, inputFile);
-        char* dot = strrchr(outputFile, '.');
-        if (dot != NULL) {
-            strcpy(dot, ".lex");
-        } else {
-            strcat(outputFile, ".lex");
-        }
-    }
-    
-    printf("Input file:  %s\n", inputFile);
-    printf("Output file: %s\n", outputFile);
-    
-    FILE* input_fp = fopen(inputFile, "r");
-    if (input_fp == NULL) {
-        printf("Error: Cannot open input file: %s\n", inputFile);
-        return 1;
+    // 后台分析还没结束时等它结束，丢弃结果
+    if (m_analysis->isRunning()) {
+        m_analysis->waitForFinished();
+        delete m_analysis->result().compilation;
     }
-    
-    FILE* output_fp = fopen(outputFile, "w");
-    if (output_fp == NULL) {
-        printf("Error: Cannot open output file: %s\n", outputFile);
-        fclose(input_fp);
-        return 1;
+    // 还在编译时结束 gcc，m_compile 随窗口一起释放
+    if (m_compile->state() != QProcess::NotRunning) {
+        m_compile->kill();
+        m_compile->waitForFinished();
     }
-    
-    analyze(input_fp, output_fp);
-    
-    fclose(input_fp);
-    fclose(output_fp);
-    
-    return 0;
-}
-)";
-
-    return lexCode;
+    delete m_comp;
+    delete m_ruleCache;
+    delete m_liveLexer;
+    delete ui;
 }
 
-// 生成 Mini-C 语言词法分析器
-QString generateMiniCLexer(QString filePath)
+/*
+* @brief 用当前的最小化DFA重新分析整个源程序编辑框
+*/
+void Widget::resetLiveLexer()
 {
-    Q_UNUSED(filePath);
-    QString lexCode;
-
-    lexCode += R"(#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-#include <ctype.h>
-
-// Token types
-typedef enum {
-    TOKEN_KEYWORD,
-    TOKEN_ID,
-    TOKEN_NUM,
-    TOKEN_FLOAT,
-    TOKEN_OPERATOR,
-    TOKEN_DELIMITER,
-    TOKEN_EOF,
-    TOKEN_ERROR
-} TokenType;
-
-// Mini-C Keywords (8 total, case-sensitive)
-const char* keywords[] = {"else", "if", "int", "float", "real", "return", "void", "while", "for"};
-const int NUM_KEYWORDS = 9;
-
-// Token counter
-int tokenCount = 0;
-
-// Check if string is a keyword
-bool isKeyword(const char* str) {
-    for (int i = 0; i < NUM_KEYWORDS; i++) {
-        if (strcmp(str, keywords[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Output a token
-void outputToken(FILE* fp, TokenType type, const char* value) {
-    tokenCount++;
-    const char* typeName;
-    switch (type) {
-        case TOKEN_KEYWORD: typeName = "KEYWORD"; break;
-        case TOKEN_ID: typeName = "ID"; break;
-        case TOKEN_NUM: typeName = "NUM"; break;
-        case TOKEN_FLOAT: typeName = "FLOAT"; break;
-        case TOKEN_OPERATOR: typeName = "OPERATOR"; break;
-        case TOKEN_DELIMITER: typeName = "DELIMITER"; break;
-        case TOKEN_EOF: typeName = "EOF"; break;
-        default: typeName = "ERROR"; break;
-    }
-    fprintf(fp, "%d: %s, %s\n", tokenCount, typeName, value);
-    printf("%d: %s, %s\n", tokenCount, typeName, value);
-}
-
-// Lexical analyzer for Mini-C
-void analyze(FILE* input_fp, FILE* output_fp) {
-    int c;
-    char buffer[1024];
-    int bufIdx;
-    
-    printf("\n=== Mini-C Lexical Analysis Results ===\n\n");
-    fprintf(output_fp, "=== Mini-C Lexical Analysis Results ===\n\n");
-    
-    while ((c = fgetc(input_fp)) != EOF) {
-        // Skip whitespace
-        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-            continue;
-        }
-        
-        // Handle line comments //
-        if (c == '/') {
-            int next = fgetc(input_fp);
-            if (next == '/') {
-                // Skip until end of line
-                while ((c = fgetc(input_fp)) != EOF && c != '\n') {
-                    // Skip comment content
-                }
-                continue;
-            } else {
-                // It's division operator
-                if (next != EOF) ungetc(next, input_fp);
-                buffer[0] = '/';
-                buffer[1] = '\0';
-                outputToken(output_fp, TOKEN_OPERATOR, buffer);
-                continue;
-            }
-        }
-        
-        // Handle identifiers and keywords (start with letter or _)
-        if (isalpha(c) || c == '_') {
-            bufIdx = 0;
-            buffer[bufIdx++] = c;
-            while ((c = fgetc(input_fp)) != EOF && (isalnum(c) || c == '_')) {
-                buffer[bufIdx++] = c;
-            }
-            buffer[bufIdx] = '\0';
-            if (c != EOF) ungetc(c, input_fp);
-            
-            if (isKeyword(buffer)) {
-                outputToken(output_fp, TOKEN_KEYWORD, buffer);
-            } else {
-                outputToken(output_fp, TOKEN_ID, buffer);
-            }
-            continue;
-        }
-        
-        // Handle numbers (integer or float)
-        if (isdigit(c)) {
-            bufIdx = 0;
-            buffer[bufIdx++] = c;
-            bool isFloat = false;
-            
-            // Read integer part
-            while ((c = fgetc(input_fp)) != EOF && isdigit(c)) {
-                buffer[bufIdx++] = c;
-            }
-            
-            // Check for decimal point
-            if (c == '.') {
-                int next = fgetc(input_fp);
-                if (isdigit(next)) {
-                    isFloat = true;
-                    buffer[bufIdx++] = c;  // Add '.'
-                    buffer[bufIdx++] = next;
-                    // Read fractional part
-                    while ((c = fgetc(input_fp)) != EOF && isdigit(c)) {
-                        buffer[bufIdx++] = c;
-                    }
-                } else {
-                    // Not a float, put back
-                    if (next != EOF) ungetc(next, input_fp);
-                    ungetc(c, input_fp);
-                    c = '.';  // Will be processed later
-                }
-            }
-            
-            buffer[bufIdx] = '\0';
-            if (c != EOF && c != '.') ungetc(c, input_fp);
-            
-            if (isFloat) {
-                outputToken(output_fp, TOKEN_FLOAT, buffer);
-            } else {
-                outputToken(output_fp, TOKEN_NUM, buffer);
-            }
-            continue;
-        }
-        
-        // Handle operators and delimiters
-        buffer[0] = c;
-        buffer[1] = '\0';
-        
-        // Check for two-character operators
-        int next = fgetc(input_fp);
-        
-        if (c == '+' && next == '+') {
-            strcpy(buffer, "++");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '-' && next == '-') {
-            strcpy(buffer, "--");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '<' && next == '=') {
-            strcpy(buffer, "<=");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '>' && next == '=') {
-            strcpy(buffer, ">=");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '=' && next == '=') {
-            strcpy(buffer, "==");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else if (c == '!' && next == '=') {
-            strcpy(buffer, "!=");
-            outputToken(output_fp, TOKEN_OPERATOR, buffer);
-        } else {
-            if (next != EOF) ungetc(next, input_fp);
-            
-            // Single character operators
-            if (c == '+' || c == '-' || c == '*' || c == '/' || 
-                c == '%' || c == '^' || c == '<' || c == '>' || c == '=' || c == '.') {
-                outputToken(output_fp, TOKEN_OPERATOR, buffer);
-            }
-            // Delimiters
-            else if (c == ';' || c == ',' || c == '(' || c == ')' || 
-                     c == '[' || c == ']' || c == '{' || c == '}') {
-                outputToken(output_fp, TOKEN_DELIMITER, buffer);
-            }
-            // Unknown character - skip
-            else {
-                // Ignore unknown characters
-            }
-        }
-    }
-    
-    printf("\nTokens saved to output file\n");
-}
-
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        printf("Mini-C Lexical Analyzer\n");
-        printf("Usage: %s <input.mc> [output.lex]\n", argv[0]);
-        printf("Example: %s sample.mc\n", argv[0]);
-        printf("         %s sample.mc result.lex\n", argv[0]);
-        return 1;
-    }
-    
-    const char* inputFile = argv[1];
-    
-    // Generate output filename
-    char outputFile[1024];
-    if (argc >= 3) {
-        strcpy(outputFile, argv[2]);
-    } else {
-        strcpy(outputFile, inputFile);
-        char* dot = strrchr(outputFile, '.');
-        if (dot != NULL) {
-            strcpy(dot, ".lex");
-        } else {
-            strcat(outputFile, ".lex");
-        }
-    }
-    
-    printf("Input file:  %s\n", inputFile);
-    printf("Output file: %s\n", outputFile);
-    
-    FILE* input_fp = fopen(inputFile, "r");
-    if (input_fp == NULL) {
-        printf("Error: Cannot open input file: %s\n", inputFile);
-        return 1;
-    }
-    
-    FILE* output_fp = fopen(outputFile, "w");
-    if (output_fp == NULL) {
-        printf("Error: Cannot open output file: %s\n", outputFile);
-        fclose(input_fp);
-        return 1;
+    if (m_liveLexer == nullptr) {
+        m_liveLexer = new IncrementalLexer;
     }
-    
-    analyze(input_fp, output_fp);
-    
-    fclose(input_fp);
-    fclose(output_fp);
-    
-    return 0;
-}
-)";
+    const LexLangProfile& profile = (ui->comboBox_lang->currentIndex() == 0) ? tinyProfile : miniCProfile;
+    QElapsedTimer timer;
+    timer.start();
+    m_liveLexer->reset(*m_comp, ui->plainTextEdit_src->toPlainText().toStdString(), profile);
+    qint64 lexTime = timer.nsecsElapsed() / 1000;
 
-    return lexCode;
+    ui->label_live->setText(QString("实时分析：%1 个单词，全部重新分析用时 %2 us")
+                                .arg((int)m_liveLexer->tokenCount()).arg(lexTime));
 }
 
-
 /*
-* @brief 初始化函数
-* 用于清空全局变量
+* @brief 源程序编辑框修改后的增量分析
+* 编辑框中的位置按UTF-16字符计，换算为UTF-8文本中的字节位置后交给 IncrementalLexer，
+* 只重新分析修改处附近的单词
 */
-void init() {
-    // 全局变量清空
-    keyWords.clear();
-    opMap.clear();
-    finalRegex.clear();
-    regexLine->clear();
-    commentSymbol->clear();
-    nodeCount = 0;
-    nfaCharSet.clear();
-    dfaCharSet.clear();
-    statusTable.clear();
-    insertionOrder.clear();
-    startNFAstatus.clear();
-    endNFAstatus.clear();
-    dfaStatusSet.clear();
-    dfaEndStatusSet.clear();
-    dfaNotEndStatusSet.clear();
-    dfaMinTable.clear();
-    divideVector.clear();
-    dfaMinMap.clear();
-    dfaTable.clear();
-    dfa2numberMap.clear();
-    varDefMap.clear();
-    regexToGenerate.clear();
-    tokenCodeMap.clear();
-    multiTokenMap.clear();
-    multiTokenList.clear();
-    varCharMap.clear();
-    charVarMap.clear();
-    // 清除动态添加的变量映射
-    for (char c = 100; c < nextVarChar; c++) {
-        m1.erase(c);
+void Widget::liveSourceChanged(int position, int charsRemoved, int charsAdded)
+{
+    if (m_liveLexer == nullptr) {
+        return;  // 还没有开始分析
     }
-    nextVarChar = (char)100;
-    nfaCharSet.insert(EPSILON); // 放入epsilon
-}
-
-/*
-* @brief 开始分析按钮
-*/
-void Widget::on_pushButton_clicked(){
-    // 清空全局变量
-    init();
 
-    // 拿到所有的正则表达式
-    QString allRegex = ui->plainTextEdit_2->toPlainText();
-
-    isLowerCase = ui->checkBox->isChecked();
-    qDebug() <<"是否区分大小写："<< isLowerCase;
-
-    string result = handleAllRegex(allRegex, isLowerCase);
-    // 如果字符串不为空就是报错了，退出
-    if (!result.empty()) {
-        QMessageBox::critical(this, "错误信息", QString::fromStdString(result));
+    // 修改处所在行之前的文本没有变，按行号找到这一行在旧文本中的位置
+    QTextDocument* doc = ui->plainTextEdit_src->document();
+    if (position + charsAdded > doc->characterCount() - 1) {
+        resetLiveLexer();  // 替换整个文档时范围包括了末尾的段落分隔符
+        return;
+    }
+    QTextBlock block = doc->findBlock(position);
+    const string& text = m_liveLexer->source();
+    size_t start = m_liveLexer->lineOffset(block.blockNumber() + 1)
+                   + block.text().left(position - block.position()).toUtf8().size();
+
+    // 删除的字符在旧文本中占的字节数，4字节的UTF-8字符是两个UTF-16字符
+    size_t end = start;
+    int units = 0;
+    while (units < charsRemoved && end < text.size()) {
+        unsigned char lead = text[end];
+        int bytes = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : (lead >= 0xC0) ? 2 : 1;
+        units += (bytes == 4) ? 2 : 1;
+        end = min(text.size(), end + bytes);
+    }
+    if (start > text.size() || units < charsRemoved) {
+        resetLiveLexer();
         return;
     }
 
-    //正则表达式转换成NFA图
-    NFA nfa = regex2NFA(finalRegex);
-
-    // NFA转DFA
-    NFA2DFA(nfa);
+    QTextCursor cursor(doc);
+    cursor.setPosition(position);
+    cursor.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+    QString inserted = cursor.selectedText().replace(QChar(QChar::ParagraphSeparator), QChar('\n'));
 
-    DFAminimize();
+    QElapsedTimer timer;
+    timer.start();
+    size_t relexed = m_liveLexer->edit(start, end - start, inserted.toStdString());
+    qint64 lexTime = timer.nsecsElapsed() / 1000;
 
-    QMessageBox::about(this, "提示", "分析成功！请点击其余按钮查看结果！");
+    ui->label_live->setText(QString("实时分析：%1 个单词，本次重新分析 %2 个单词，用时 %3 us")
+                                .arg((int)m_liveLexer->tokenCount()).arg((int)relexed).arg(lexTime));
 }
 
 /*
@@ -2047,46 +409,30 @@ void Widget::on_pushButton_4_clicked()
     ui->tableWidget->setRowCount(0); // 清除所有行
     ui->tableWidget->setColumnCount(0); // 清除所有列
     // 设置列数
-    int n = 2 + nfaCharSet.size(); // 默认两列：Flag 和 ID
+    int n = 2 + m_comp->nfaCharSet.size(); // 默认两列：Flag 和 ID
     ui->tableWidget->setColumnCount(n);
 
-    // 字符和第X列存起来对应
-    map<char, int> headerCharNum;
+    // 符号和第X列存起来对应
+    map<int, int> headerCharNum;
 
     // 设置表头
     QStringList headerLabels;
     headerLabels << "标志" << "ID";
     int headerCount = 3;
-    for (const auto& ch : nfaCharSet) {
-        if (m1.find(ch) != m1.end()) {
-            headerLabels << QString::fromStdString(trim(m1[ch]));
-        }
-        else {
-            if (ch == '~') {
-                char tt = commentSymbol[1][0];
-                string res = commentSymbol[1];
-                if (m1.find(tt) != m1.end()) {
-                    res = trim(m1[tt]);
-                }
-                headerLabels << QString::fromStdString("非" + res);
-            }
-            else {
-                headerLabels << QString(ch);
-            }
-        }
-
-        headerCharNum[ch] = headerCount++;
+    for (int sym : m_comp->nfaCharSet) {
+        headerLabels << QString::fromStdString(m_comp->symbolName(sym));
+        headerCharNum[sym] = headerCount++;
     }
     ui->tableWidget->setHorizontalHeaderLabels(headerLabels);
 
     // 设置行数
-    int rowCount = statusTable.size();
+    int rowCount = m_comp->statusTable.size();
     ui->tableWidget->setRowCount(rowCount);
 
     // 填充数据
     int row = 0;
-    for (auto id : insertionOrder) {
-        const statusTableNode& node = statusTable[id];
+    for (auto id : m_comp->insertionOrder) {
+        const statusTableNode& node = m_comp->statusTable[id];
 
         // Flag 列
         ui->tableWidget->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(node.flag)));
@@ -2125,58 +471,42 @@ void Widget::on_pushButton_3_clicked()
     ui->tableWidget->setColumnCount(0); // 清除所有列
 
     // 设置列数
-    int n = 2 + dfaCharSet.size(); // 默认两列：Flag 和 状态集合
+    int n = 2 + m_comp->dfaCharSet.size(); // 默认两列：Flag 和 状态集合
     ui->tableWidget->setColumnCount(n);
 
-    // 字符和第X列存起来对应
-    map<char, int> headerCharNum;
+    // 符号和第X列存起来对应
+    map<int, int> headerCharNum;
 
     // 设置表头
     QStringList headerLabels;
     headerLabels << "标志" << "状态集合";
     int headerCount = 3;
-    for (const auto& ch : dfaCharSet) {
-        if (m1.find(ch) != m1.end()) {
-            headerLabels << QString::fromStdString(trim(m1[ch]));
-        }
-        else {
-            if (ch == '~') {
-                char tt = commentSymbol[1][0];
-                string res = commentSymbol[1];
-                if (m1.find(tt) != m1.end()) {
-                    res = trim(m1[tt]);
-                }
-                headerLabels << QString::fromStdString("非" + res);
-            }
-            else {
-                headerLabels << QString(ch);
-            }
-        }
-
-        headerCharNum[ch] = headerCount++;
+    for (int sym : m_comp->dfaCharSet) {
+        headerLabels << QString::fromStdString(m_comp->symbolName(sym));
+        headerCharNum[sym] = headerCount++;
     }
     ui->tableWidget->setHorizontalHeaderLabels(headerLabels);
     // 设置行数
-    int rowCount = dfaTable.size();
+    int rowCount = m_comp->dfaTable.size();
     ui->tableWidget->setRowCount(rowCount);
 
     // 填充数据
     int row = 0;
-    for (auto& dfaNode : dfaTable) {
+    for (auto& dfaNode : m_comp->dfaTable) {
 
         // Flag 列
-        ui->tableWidget->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(dfaNode.flag)));
+        ui->tableWidget->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(dfaNode.flag + m_comp->tagLabel(dfaNode.tag))));
 
         // 状态集合 列
-        ui->tableWidget->setItem(row, 1, new QTableWidgetItem(QString::fromStdString("{" + set2string(dfaNode.nfaStates) + "}")));
+        ui->tableWidget->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(m_comp->dfaStateLabel(row + 1))));
 
         // 状态转换 列
         int col = 2;
         for (const auto& transitionEntry : dfaNode.transitions) {
-            string re = set2string(transitionEntry.second);
+            string re = m_comp->dfaStateLabel(transitionEntry.second);
 
             // 放到指定列数据
-            ui->tableWidget->setItem(row, headerCharNum[transitionEntry.first] - 1, new QTableWidgetItem(QString::fromStdString("{" + re + "}")));
+            ui->tableWidget->setItem(row, headerCharNum[transitionEntry.first] - 1, new QTableWidgetItem(QString::fromStdString(re)));
             col++;
         }
 
@@ -2200,48 +530,32 @@ void Widget::on_pushButton_5_clicked()
     ui->tableWidget->setColumnCount(0); // 清除所有列
 
     // 设置列数
-    int n = 2 + dfaCharSet.size(); // 默认两列：Flag 和 状态集合
+    int n = 2 + m_comp->dfaCharSet.size(); // 默认两列：Flag 和 状态集合
     ui->tableWidget->setColumnCount(n);
 
-    // 字符和第X列存起来对应
-    map<char, int> headerCharNum;
+    // 符号和第X列存起来对应
+    map<int, int> headerCharNum;
 
     // 设置表头
     QStringList headerLabels;
     headerLabels << "标志" << "ID";
     int headerCount = 3;
-    for (const auto& ch : dfaCharSet) {
-        if (m1.find(ch) != m1.end()) {
-            headerLabels << QString::fromStdString(trim(m1[ch]));
-        }
-        else {
-            if (ch == '~') {
-                char tt = commentSymbol[1][0];
-                string res = commentSymbol[1];
-                if (m1.find(tt) != m1.end()) {
-                    res = trim(m1[tt]);
-                }
-                headerLabels << QString::fromStdString("非" + res);
-            }
-            else {
-                headerLabels << QString(ch);
-            }
-        }
-
-        headerCharNum[ch] = headerCount++;
+    for (int sym : m_comp->dfaCharSet) {
+        headerLabels << QString::fromStdString(m_comp->symbolName(sym));
+        headerCharNum[sym] = headerCount++;
     }
     ui->tableWidget->setHorizontalHeaderLabels(headerLabels);
 
     // 设置行数
-    int rowCount = dfaMinTable.size();
+    int rowCount = m_comp->dfaMinTable.size();
     ui->tableWidget->setRowCount(rowCount);
 
     // 填充数据
     int row = 0;
-    for (auto& dfaNode : dfaMinTable) {
+    for (auto& dfaNode : m_comp->dfaMinTable) {
 
         // Flag 列
-        ui->tableWidget->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(dfaNode.flag)));
+        ui->tableWidget->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(dfaNode.flag + m_comp->tagLabel(dfaNode.tag))));
 
         // 状态集合 列
         ui->tableWidget->setItem(row, 1, new QTableWidgetItem(QString::number(dfaNode.id)));
@@ -2271,6 +585,11 @@ void Widget::on_pushButton_2_clicked()
 {
     // 只生成代码，不编译不运行
     QString srcFilePath;
+
+    if (m_comp->dfaMinTable.empty()) {
+        QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("请先点击[开始分析]生成最小化DFA！"));
+        return;
+    }
     
     // 根据选择的语言类型设置不同的提示
     int langIndex = ui->comboBox_lang->currentIndex();
@@ -2287,13 +606,9 @@ void Widget::on_pushButton_2_clicked()
 
     qDebug() << "生成" << langName << "词法分析程序...";
     
-    // 根据语言类型生成不同的词法分析器
-    QString res;
-    if (langIndex == 0) {
-        res = generateLexer(srcFilePath);  // TINY
-    } else {
-        res = generateMiniCLexer(srcFilePath);  // Mini-C
-    }
+    // 由最小化DFA生成词法分析器，语言只决定注释等补充信息
+    LexerBackend backend = (ui->comboBox_codegen->currentIndex() == 1) ? LEXER_DIRECT : LEXER_TABLE;
+    QString res = QString::fromStdString(m_comp->generateLexer(langIndex, backend));
     qDebug() << "词法分析程序生成完成...";
 
     /*==========文件处理=================*/
@@ -2325,13 +640,21 @@ void Widget::on_pushButton_2_clicked()
     }
 }
 
+/*
+* @brief 编译按钮
+* 用 gcc 检查生成的 lexer.c 能否编译，得到的可执行文件可以在程序外使用；
+* 编译在后台进程中进行，结束后由 compileFinished 输出结果，界面不等待
+*/
 void Widget::on_pushButton_10_clicked()
 {
-    // 编译
     if (m_lexerPath.isEmpty()) {
         QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("请先点击[生成代码]生成词法分析器！"));
         return;
     }
+    if (m_compile->state() != QProcess::NotRunning) {
+        QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("正在编译，请等待编译结束！"));
+        return;
+    }
 
     QString cFilePath = m_lexerPath + "/lexer.c";
     if (!QFile::exists(cFilePath)) {
@@ -2339,48 +662,48 @@ void Widget::on_pushButton_10_clicked()
         return;
     }
 
-    m_exePath = m_lexerPath + "/lexer";
+    QString exePath = m_lexerPath + "/lexer";
     #ifdef Q_OS_WIN
-    m_exePath += ".exe";
+    exePath += ".exe";
     #endif
 
-    QProcess compileProcess;
     QStringList compileArgs;
-    compileArgs << cFilePath << "-o" << m_exePath;
+    compileArgs << cFilePath << "-o" << exePath;
 
     ui->tableWidget->hide();
     ui->plainTextEdit->show();
     ui->plainTextEdit->appendPlainText("\n\n[正在编译] gcc " + compileArgs.join(" "));
 
-    compileProcess.start("gcc", compileArgs);
-    if (!compileProcess.waitForFinished()) {
-        ui->plainTextEdit->appendPlainText("[编译失败] 无法启动 gcc，请确保已安装 gcc 并添加到环境变量。");
-        return;
-    }
+    m_compile->start("gcc", compileArgs);
+}
 
-    if (compileProcess.exitCode() != 0) {
-        ui->plainTextEdit->appendPlainText("[编译错误]:\n" + compileProcess.readAllStandardError());
+// 编译进程结束，可执行文件是 gcc 的最后一个参数
+void Widget::compileFinished(int exitCode)
+{
+    if (exitCode != 0) {
+        ui->plainTextEdit->appendPlainText("[编译错误]:\n" + m_compile->readAllStandardError());
         return;
     }
-
-    ui->plainTextEdit->appendPlainText("[编译成功] 可执行文件: " + m_exePath);
+    ui->plainTextEdit->appendPlainText("[编译成功] 可执行文件: " + m_compile->arguments().last());
 }
 
-void Widget::on_pushButton_11_clicked()
+// gcc 没有启动时不会有 finished 信号
+void Widget::compileFailed(QProcess::ProcessError error)
 {
-    // 测试（运行词法分析器）- 选择源文件进行测试
-    if (m_lexerPath.isEmpty()) {
-        QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("请先点击[生成代码]生成词法分析器！"));
-        return;
+    if (error == QProcess::FailedToStart) {
+        ui->plainTextEdit->appendPlainText("[编译失败] 无法启动 gcc，请确保已安装 gcc 并添加到环境变量。");
     }
+}
 
-    QString exePath = m_lexerPath + "/lexer";
-    #ifdef Q_OS_WIN
-    exePath += ".exe";
-    #endif
-
-    if (!QFile::exists(exePath)) {
-        QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("未找到可执行文件，请先点击[编译]编译词法分析器！"));
+/*
+* @brief 测试按钮
+* 在程序内用最小化DFA扫描映射到内存的源文件，不需要生成、编译词法分析程序，
+* 结果和生成的词法分析程序相同
+*/
+void Widget::on_pushButton_11_clicked()
+{
+    if (m_comp->dfaMinTable.empty()) {
+        QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("请先点击[开始分析]生成最小化DFA！"));
         return;
     }
 
@@ -2390,68 +713,117 @@ void Widget::on_pushButton_11_clicked()
     QString fileFilter = (langIndex == 0) ? 
         QString::fromUtf8("TINY源文件 (*.tny);;所有文件 (*.*)") :
         QString::fromUtf8("Mini-C源文件 (*.mc *.c);;所有文件 (*.*)");
-    QString defaultExt = (langIndex == 0) ? ".tny" : ".mc";
 
     // 让用户选择源文件
     QString srcFile = QFileDialog::getOpenFileName(this, 
         QString::fromUtf8("选择") + langName + QString::fromUtf8("源文件"), 
-        m_lexerPath, 
+        m_lexerPath.isEmpty() ? QDir::homePath() : m_lexerPath,
         fileFilter);
     
     if (srcFile.isEmpty()) {
         return;  // 用户取消了选择
     }
 
-    // 生成输出文件路径（替换扩展名为 .lex）
-    QString outputLexPath = srcFile;
-    if (outputLexPath.endsWith(".tny", Qt::CaseInsensitive) || 
-        outputLexPath.endsWith(".mc", Qt::CaseInsensitive) ||
-        outputLexPath.endsWith(".c", Qt::CaseInsensitive)) {
-        int dotPos = outputLexPath.lastIndexOf('.');
-        outputLexPath = outputLexPath.left(dotPos) + ".lex";
-    } else {
-        outputLexPath += ".lex";
+    MappedSource source(srcFile);
+    string error = source.open();
+    if (!error.empty()) {
+        QMessageBox::warning(this, "错误", QString::fromStdString(error));
+        return;
+    }
+
+    // 生成输出文件路径（替换扩展名为 .lexb 或 .lex）
+    bool textMode = ui->checkBox_lexText->isChecked();
+    QString outputLexPath = lexOutputPath(srcFile, textMode);
+
+    const LexLangProfile& profile = (langIndex == 0) ? tinyProfile : miniCProfile;
+    QElapsedTimer timer;
+    timer.start();
+    DFAScanner scanner(*m_comp);
+    int chunkCount = parallelChunkCount(source.size());
+    int relexCount = 0;
+    vector<ScanToken> tokens = scanSourceParallel(scanner, profile, source.data(), source.size(), chunkCount, relexCount);
+    qint64 lexTime = timer.elapsed();
+    string result = m_comp->lexText(tokens, source.data(), profile);
+
+    error = saveLexResult(*m_comp, outputLexPath, textMode, result, tokens, source, profile);
+    if (!error.empty()) {
+        QMessageBox::warning(this, "错误", QString::fromStdString(error));
     }
 
     ui->tableWidget->hide();
     ui->plainTextEdit->show();
-    ui->plainTextEdit->appendPlainText("\n\n[正在运行" + langName + QString::fromUtf8("词法分析器...]"));
+    ui->plainTextEdit->appendPlainText("\n\n[运行" + langName + QString::fromUtf8("词法分析]"));
     ui->plainTextEdit->appendPlainText(QString::fromUtf8("输入文件: ") + srcFile);
     ui->plainTextEdit->appendPlainText(QString::fromUtf8("输出文件: ") + outputLexPath);
+    ui->plainTextEdit->appendPlainText(QString("%1 字节，%2 个单词，用时 %3 ms")
+                                       .arg((int)source.size()).arg((int)tokens.size()).arg(lexTime));
+    if (chunkCount > 1) {
+        ui->plainTextEdit->appendPlainText(QString("分 %1 块并行分析，推测失败重新分析 %2 块").arg(chunkCount).arg(relexCount));
+    }
+    ui->plainTextEdit->appendPlainText(QString::fromUtf8("=== ") + langName + QString::fromUtf8(" 词法分析结果 ===\n"));
+    ui->plainTextEdit->appendPlainText(QString::fromStdString(result));
+}
 
-    QProcess runProcess;
-    runProcess.setWorkingDirectory(m_lexerPath);
-    
-    // 使用命令行参数运行: ./lexer input.xxx output.lex
-    QStringList args;
-    args << srcFile << outputLexPath;
-    
-    runProcess.start(exePath, args);
-    if (!runProcess.waitForFinished()) {
-         ui->plainTextEdit->appendPlainText(QString::fromUtf8("[运行失败]"));
-         return;
+/*
+* @brief 直接分析按钮
+* 不生成和编译代码，用按需构造的DFA在程序内分析源文件，
+* 规则产生的DFA太大、无法完整构造时也能使用
+*/
+void Widget::on_pushButton_12_clicked()
+{
+    if (m_comp->nfaArena.stateCount == 0 || m_comp->closureWords == 0) {
+        QMessageBox::warning(this, QString::fromUtf8("提示"), QString::fromUtf8("请先点击[开始分析]构造NFA！"));
+        return;
     }
 
-    // 显示程序输出
-    QString stdOutput = runProcess.readAllStandardOutput();
-    QString stdError = runProcess.readAllStandardError();
-    
-    if (!stdError.isEmpty()) {
-        ui->plainTextEdit->appendPlainText(QString::fromUtf8("\n[错误输出]:\n") + stdError);
+    int langIndex = ui->comboBox_lang->currentIndex();
+    QString langName = (langIndex == 0) ? "TINY" : "Mini-C";
+    QString fileFilter = (langIndex == 0) ?
+        QString::fromUtf8("TINY源文件 (*.tny);;所有文件 (*.*)") :
+        QString::fromUtf8("Mini-C源文件 (*.mc *.c);;所有文件 (*.*)");
+
+    QString srcFile = QFileDialog::getOpenFileName(this,
+        QString::fromUtf8("选择") + langName + QString::fromUtf8("源文件"),
+        m_lexerPath.isEmpty() ? QDir::homePath() : m_lexerPath,
+        fileFilter);
+    if (srcFile.isEmpty()) {
+        return;  // 用户取消了选择
     }
 
-    ui->plainTextEdit->appendPlainText(QString::fromUtf8("\n[运行成功]\n"));
-    ui->plainTextEdit->appendPlainText(QString::fromUtf8("=== ") + langName + QString::fromUtf8(" 词法分析结果 ===\n"));
+    MappedSource source(srcFile);
+    string error = source.open();
+    if (!error.empty()) {
+        QMessageBox::warning(this, "错误", QString::fromStdString(error));
+        return;
+    }
 
-    // 读取生成的 .lex 文件
-    QFile lexFile(outputLexPath);
-    if (lexFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&lexFile);
-        ui->plainTextEdit->appendPlainText(in.readAll());
-        lexFile.close();
-    } else {
-        ui->plainTextEdit->appendPlainText(QString::fromUtf8("[错误] 无法读取 ") + outputLexPath);
+    // 输出文件和[测试]一样放在源文件旁边
+    bool textMode = ui->checkBox_lexText->isChecked();
+    QString outputLexPath = lexOutputPath(srcFile, textMode);
+
+    const LexLangProfile& profile = (langIndex == 0) ? tinyProfile : miniCProfile;
+    LazyDFA dfa(*m_comp, lazyCacheBytes);
+    QElapsedTimer timer;
+    timer.start();
+    vector<ScanToken> tokens = scanSource(dfa, profile, source.data(), source.size());
+    qint64 lexTime = timer.elapsed();
+    string result = m_comp->lexText(tokens, source.data(), profile);
+
+    error = saveLexResult(*m_comp, outputLexPath, textMode, result, tokens, source, profile);
+    if (!error.empty()) {
+        QMessageBox::warning(this, "错误", QString::fromStdString(error));
     }
+
+    ui->tableWidget->hide();
+    ui->plainTextEdit->show();
+    ui->plainTextEdit->appendPlainText("\n\n[直接分析" + langName + QString::fromUtf8("源文件]"));
+    ui->plainTextEdit->appendPlainText(QString::fromUtf8("输入文件: ") + srcFile);
+    ui->plainTextEdit->appendPlainText(QString::fromUtf8("输出文件: ") + outputLexPath);
+    ui->plainTextEdit->appendPlainText(QString("用时 %1 ms，构造DFA状态 %2 个，缓存中 %3 个（上限 %4），清空缓存 %5 次")
+                                       .arg(lexTime).arg((int)dfa.builtCount).arg((int)dfa.cachedStates())
+                                       .arg((int)dfa.maxStates).arg((int)dfa.flushCount));
+    ui->plainTextEdit->appendPlainText(QString::fromUtf8("=== ") + langName + QString::fromUtf8(" 词法分析结果 ===\n"));
+    ui->plainTextEdit->appendPlainText(QString::fromStdString(result));
 }
 
 /*
@@ -2467,7 +839,7 @@ void Widget::on_pushButton_6_clicked()
         QFile file(filePath);
         if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
             QMessageBox::critical(this, "错误信息", "导入错误！无法打开文件，请检查路径和文件是否被占用！");
-            cerr << "Error opening file." << endl;
+            qWarning() << "Error opening file:" << filePath;
             return;
         }
 
@@ -2506,14 +878,33 @@ void Widget::on_pushButton_7_clicked()
 */
 void Widget::on_pushButton_8_clicked()
 {
-    QString filePath = QFileDialog::getOpenFileName(this, tr("选择文件"), QDir::homePath(), tr("LEX文件 (*.lex)"));
+    QString filePath = QFileDialog::getOpenFileName(this, tr("选择文件"), QDir::homePath(), tr("LEX文件 (*.lexb *.lex)"));
+
+    // 二进制单词文件映射到内存后转成文本显示
+    if (filePath.endsWith(".lexb", Qt::CaseInsensitive))
+    {
+        MappedSource source(filePath);
+        string text;
+        string error = source.open();
+        if (error.empty()) {
+            error = lexbToText(source.data(), source.size(), text);
+        }
+        if (!error.empty()) {
+            QMessageBox::critical(this, "错误信息", QString::fromStdString(error));
+            return;
+        }
+        ui->tableWidget->hide();
+        ui->plainTextEdit->show();
+        ui->plainTextEdit->setPlainText(QString::fromStdString(text));
+        return;
+    }
 
     if (!filePath.isEmpty())
     {
         QFile file(filePath);
         if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
             QMessageBox::critical(this, "错误信息", "导入错误！无法打开文件，请检查路径和文件是否被占用！");
-            cerr << "Error opening file." << endl;
+            qWarning() << "Error opening file:" << filePath;
             return;
         }
 
@@ -2,11 +2,29 @@
 #define WIDGET_H
 
 #include <QWidget>
+#include <QString>
+#include <QFutureWatcher>
+#include <QProcess>
+#include <string>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class Widget; }
 QT_END_NAMESPACE
 
+class IncrementalLexer;
+class LexerCompilation;
+class RuleDFACache;
+
+// 后台分析的结果，分析结束后交给界面线程。
+// QFutureWatcher<AnalysisResult> 在构造函数中实例化，需要完整的定义，所以放在头文件中
+struct AnalysisResult
+{
+    LexerCompilation* compilation = nullptr;    // 新的编译结果，规则有错时为空
+    std::string error;                          // 规则的错误信息
+    bool tooManyStates = false;                 // DFA状态太多，只构造到NFA
+    QString report;                             // 各阶段的状态数和用时
+};
+
 class Widget : public QWidget
 {
     Q_OBJECT
@@ -37,9 +55,25 @@ private slots:
 
     void on_pushButton_11_clicked();
 
+    void on_pushButton_12_clicked();
+
+    void liveSourceChanged(int position, int charsRemoved, int charsAdded);
+
+    void analysisFinished();
+
+    void compileFinished(int exitCode);
+
+    void compileFailed(QProcess::ProcessError error);
+
 private:
     Ui::Widget *ui;
     QString m_lexerPath;   // 保存生成的词法分析器路径
-    QString m_exePath;     // 保存编译后的可执行文件路径
+    IncrementalLexer* m_liveLexer;  // 源程序编辑框的增量词法分析，开始分析后创建
+    LexerCompilation* m_comp;       // 界面显示的编译结果，后台分析成功后才替换
+    QFutureWatcher<AnalysisResult>* m_analysis;  // 后台的分析
+    RuleDFACache* m_ruleCache;      // 按规则构造DFA时各规则的DFA，下次分析时没改的规则直接使用
+    QProcess* m_compile;            // 后台编译生成的词法分析程序，不阻塞界面
+
+    void resetLiveLexer();
 };
 #endif // WIDGET_H
@@ -1176,6 +1176,8 @@ QString generateTreeCode(QString filePath, QString lexFilePath, QString funQStr)
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <cstring>
+#include <cstdint>
 
 using namespace std;
 )";
@@ -1260,9 +1262,86 @@ string convertToken(const string& tokenType, const string& tokenValue) {
     return tokenType;
 }
 
+// 二进制单词文件(.lexb)：文件头、单词类别表、单词表、字符串池，整数为小端序uint32_t
+struct LexbHeader {
+    char magic[4];          // "LEXB"
+    uint32_t version;
+    uint32_t typeCount;
+    uint32_t tokenCount;
+    uint32_t poolSize;
+    char language[12];
+};
+struct LexbType {
+    uint32_t code, nameOffset, nameLength;
+};
+struct LexbToken {
+    uint32_t code, offset, length, line;
+};
+
+// 读取二进制单词文件：整个文件读入内存后直接按结构体访问，不需要逐行解析
+// 各表的个数和单词在字符串池中的位置都先和文件大小比较，格式不对的文件不会读到缓冲区外
+vector<KeyValue> readLexbPairs(const char* data, size_t size) {
+    vector<KeyValue> keyValuePairs;
+    LexbHeader header;
+    if (size < sizeof(header)) {
+        cerr << "二进制单词文件不完整" << endl;
+        return keyValuePairs;
+    }
+    memcpy(&header, data, sizeof(header));
+    size_t typesAt = sizeof(LexbHeader);
+    if (header.version != 1 || header.typeCount > (size - typesAt) / sizeof(LexbType)) {
+        cerr << "二进制单词文件格式错误" << endl;
+        return keyValuePairs;
+    }
+    size_t tokensAt = typesAt + (size_t)header.typeCount * sizeof(LexbType);
+    if (header.tokenCount > (size - tokensAt) / sizeof(LexbToken)) {
+        cerr << "二进制单词文件格式错误" << endl;
+        return keyValuePairs;
+    }
+    size_t poolAt = tokensAt + (size_t)header.tokenCount * sizeof(LexbToken);
+    if (header.poolSize > size - poolAt) {
+        cerr << "二进制单词文件格式错误" << endl;
+        return keyValuePairs;
+    }
+    const char* pool = data + poolAt;
+
+    string language(header.language, strnlen(header.language, sizeof(header.language)));
+    isTinyLanguage = (language.find("Mini-C") == string::npos && language.find("MiniC") == string::npos);
+
+    map<uint32_t, string> typeName;
+    for (uint32_t i = 0; i < header.typeCount; i++) {
+        LexbType type;
+        memcpy(&type, data + typesAt + i * sizeof(LexbType), sizeof(type));
+        if (type.nameOffset > header.poolSize || type.nameLength > header.poolSize - type.nameOffset) {
+            cerr << "二进制单词文件中的类别名称越界" << endl;
+            return vector<KeyValue>();
+        }
+        typeName.insert({type.code, string(pool + type.nameOffset, type.nameLength)});
+    }
+
+    const string unknownType;
+    keyValuePairs.resize(header.tokenCount);
+    for (uint32_t i = 0; i < header.tokenCount; i++) {
+        LexbToken token;
+        memcpy(&token, data + tokensAt + i * sizeof(LexbToken), sizeof(token));
+        if (token.offset > header.poolSize || token.length > header.poolSize - token.offset) {
+            cerr << "二进制单词文件中第 " << i + 1 << " 个单词越界" << endl;
+            return vector<KeyValue>();
+        }
+        // 单词的值直接从字符串池复制到结果中，不经过临时字符串
+        KeyValue& pair = keyValuePairs[i];
+        pair.value.assign(pool + token.offset, token.length);
+        auto type = typeName.find(token.code);
+        pair.key = convertToken(type == typeName.end() ? unknownType : type->second, pair.value);
+    }
+    keyValuePairs.push_back({ "EOF", "$" });
+    return keyValuePairs;
+}
+
 // 函数读取并分隔每一行的键值对 (适配词法分析器输出格式)
+// 以"LEXB"开头的是二进制单词文件，否则按文本 .lex 文件逐行解析
 vector<KeyValue> readKeyValuePairs(const string& filename) {
-    ifstream file(filename);
+    ifstream file(filename, ios::binary);
     vector<KeyValue> keyValuePairs;
 
     if (!file) {
@@ -1270,6 +1349,19 @@ vector<KeyValue> readKeyValuePairs(const string& filename) {
         return keyValuePairs;
     }
 
+    char magic[4] = {};
+    file.read(magic, sizeof(magic));
+    file.clear();
+    file.seekg(0);
+    if (memcmp(magic, "LEXB", 4) == 0) {
+        // 按文件大小一次读入，不经过 stringstream 再复制一遍
+        file.seekg(0, ios::end);
+        string data((size_t)file.tellg(), '\0');
+        file.seekg(0);
+        file.read(&data[0], data.size());
+        return readLexbPairs(data.data(), (size_t)file.gcount());
+    }
+
     // 检测文件类型
     string firstLine;
     getline(file, firstLine);
@@ -1298,7 +1390,7 @@ vector<KeyValue> readKeyValuePairs(const string& filename) {
         tokenType.erase(0, tokenType.find_first_not_of(" \t"));
         tokenType.erase(tokenType.find_last_not_of(" \t") + 1);
         tokenValue.erase(0, tokenValue.find_first_not_of(" \t"));
-        tokenValue.erase(tokenValue.find_last_not_of(" \t") + 1);
+        tokenValue.erase(tokenValue.find_last_not_of(" \t\r") + 1);
         
         string convertedType = convertToken(tokenType, tokenValue);
         
@@ -2570,7 +2662,7 @@ void Widget::on_pushButton_8_clicked()
         srcFilePath = t_filePath;
 
     // 选择lex文件
-    QString lexFilePath = QFileDialog::getOpenFileName(this, tr("选择词法分析输出文件"), srcFilePath, tr("Lex文件 (*.lex);;所有文件 (*.*)"));
+    QString lexFilePath = QFileDialog::getOpenFileName(this, tr("选择词法分析输出文件"), srcFilePath, tr("单词文件 (*.lexb *.lex);;所有文件 (*.*)"));
     if (lexFilePath.isEmpty()) {
         QMessageBox::warning(this, "提示", "未选择词法分析文件");
         return;